@@ -202,6 +202,9 @@ inline void Band::breset() {
     inf = 0;
     sup = 0;
     mid = 0;
+#ifdef RF433ANY_ADAPTIVE_BANDS
+    nb = 0;
+#endif
 }
 
 inline bool Band::init(uint16_t d) {
@@ -215,6 +218,11 @@ inline bool Band::init(uint16_t d) {
         inf = d - d_divided_by_4;
         sup = d + d_divided_by_4;
         got_it = true;
+#ifdef RF433ANY_ADAPTIVE_BANDS
+        mean_fp = (uint32_t)d << 4;
+        dev_fp = 0;
+        nb = 1;
+#endif
     } else {
         got_it = false;
     }
@@ -236,6 +244,45 @@ inline bool Band::init_sep(uint16_t d) {
     return got_it;
 }
 
+#ifdef RF433ANY_ADAPTIVE_BANDS
+
+    // Exponential moving averages, with a weight of 1/2 for the second
+    // duration, 1/4 for the next two, then 1/8. Shifts only (no
+    // multiplication nor division), as it runs for each edge.
+void Band::add_sample(uint16_t d) {
+    byte k = (nb < 2 ? 1 : (nb < 4 ? 2 : 3));
+    uint32_t x = (uint32_t)d << 4;
+    uint32_t dev;
+    if (x >= mean_fp) {
+        dev = x - mean_fp;
+        mean_fp += dev >> k;
+    } else {
+        dev = mean_fp - x;
+        mean_fp -= dev >> k;
+    }
+    if (dev >= dev_fp)
+        dev_fp += (dev - dev_fp) >> k;
+    else
+        dev_fp -= (dev_fp - dev) >> k;
+    if (nb < 255)
+        ++nb;
+    mid = (mean_fp + 8) >> 4;
+}
+
+    // Half the width of the tolerance window: 4 times the mean deviation
+    // (dev_fp >> 2), within 25% and 37.5% of mid.
+uint16_t Band::get_halfwidth() const {
+    uint16_t w = mid >> 2;
+    uint32_t w_dev = dev_fp >> 2;
+    if (w_dev > w) {
+        uint16_t w_max = w + (mid >> 3);
+        w = (w_dev > w_max ? w_max : w_dev);
+    }
+    return w;
+}
+
+#endif // RF433ANY_ADAPTIVE_BANDS
+
 inline bool Band::test_value_init_if_needed(uint16_t d) {
     if (!mid) {
         init(d);
@@ -284,15 +331,250 @@ inline void Rail::rreset() {
     b_short.breset();
     b_long.breset();
     b_sep.breset();
+#ifdef RF433ANY_MULTI_BANDS
+    nb_extra = 0;
+#endif
+#ifdef RF433ANY_RAIL_LUT
+    lut_ready = false;
+#endif
 }
 
 inline void Rail::rreset_soft() {
     status = RAIL_OPEN;
     index = 0;
     rec = 0;
+#ifdef RF433ANY_MULTI_BANDS
+    rec2 = 0;
+#endif
+}
+
+#ifdef RF433ANY_RAIL_LUT
+
+inline void Rail::lut_set(uint16_t c, byte v) {
+    byte shift = (c & 3) << 1;
+    lut[c >> 2] = (lut[c >> 2] & ~(3 << shift)) | (v << shift);
+}
+
+    // Gives the class v to the compacted durations of [inf, sup].
+    // Compacted duration c stands for durations from uncompact(c) to
+    // uncompact(c + 1) - 1: at both ends, c can be partly in [inf, sup], it
+    // is then given the class RAIL_LUT_OTHER.
+void Rail::lut_fill(uint16_t inf, uint16_t sup, byte v) {
+    uint16_t c_inf = compact(inf);
+    uint16_t c_sup = compact(sup);
+    for (uint16_t c = c_inf; c <= c_sup; ++c)
+        lut_set(c, v);
+    if (uncompact(c_inf) != inf)
+        lut_set(c_inf, RAIL_LUT_OTHER);
+    if (c_sup != 255 && uncompact(c_sup + 1) - 1 != sup)
+        lut_set(c_sup, RAIL_LUT_OTHER);
+}
+
+    // The bands are filled from the lowest priority to the highest: a
+    // duration that is in b_short or in b_long (but not both) is SHORT or
+    // LONG, even if it is in b_sep, too.
+    // If b_short and b_long overlap, the table is left empty (all
+    // durations are classified by comparisons).
+void Rail::lut_build() {
+    memset(lut, 0, sizeof(lut));
+    if (b_short.sup < b_long.inf) {
+        if (b_sep.mid)
+            lut_fill(b_sep.inf, b_sep.sup, RAIL_LUT_SEP);
+        lut_fill(b_short.inf, b_short.sup, RAIL_LUT_SHORT);
+        lut_fill(b_long.inf, b_long.sup, RAIL_LUT_LONG);
+    }
+    lut_ready = true;
+}
+
+#ifdef RF433ANY_DBG_SIMULATE
+    // Class of d found by comparisons with the bands, as rail_eat_bands() does
+    // once the rail has two bands, to check the table against.
+byte Rail::lut_class_by_bands(uint16_t d) const {
+    bool in_short = (d >= b_short.inf && d <= b_short.sup);
+    bool in_long = (d >= b_long.inf && d <= b_long.sup);
+    if (in_short != in_long)
+        return (in_short ? RAIL_LUT_SHORT : RAIL_LUT_LONG);
+    if (b_sep.mid && d >= b_sep.inf && d <= b_sep.sup)
+        return RAIL_LUT_SEP;
+    return RAIL_LUT_OTHER;
 }
+#endif
+
+#endif // RF433ANY_RAIL_LUT
 
 inline bool Rail::rail_eat(uint16_t d) {
+#ifdef RF433ANY_RAIL_LUT
+    if (status == RAIL_OPEN && lut_ready) {
+        byte c = lut_get(compact(d));
+        if (c != RAIL_LUT_OTHER) {
+#ifdef RF433ANY_DBG_SIMULATE
+                // Check the table gives the same class as comparisons
+            assert(c == lut_class_by_bands(d));
+#endif
+            if (c == RAIL_LUT_SEP) {
+                status = RAIL_STP_RCVD;
+            } else {
+                last_bit_recorded = (c == RAIL_LUT_LONG ? 1 : 0);
+                rec = (rec << 1) | last_bit_recorded;
+                if (++index == (sizeof(rec) << 3))
+                    status = RAIL_FULL;
+            }
+            return (status == RAIL_OPEN);
+        }
+    }
+#endif
+    return rail_eat_bands(d);
+}
+
+inline void Rail::set_default_bounds(Band *pshort, Band *plong) const {
+    pshort->inf = (pshort->mid >> 1) - (pshort->mid >> 3);
+    if (mood == RAIL_MOOD_LAXIST) {
+        pshort->sup = (pshort->mid + plong->mid) >> 1;
+        plong->inf = pshort->sup + 1;
+    }
+#ifdef RF433ANY_ADAPTIVE_BANDS
+    else {
+        pshort->sup = pshort->mid + pshort->get_halfwidth();
+        plong->inf = plong->mid - plong->get_halfwidth();
+    }
+#endif
+    plong->sup = plong->mid + (plong->mid >> 1) + (plong->mid >> 3);
+}
+
+    // Boundaries of the bands, once b_short and b_long are known.
+inline void Rail::set_bounds() {
+#ifdef RF433ANY_MULTI_BANDS
+        // Each band is mid +/- 31.25% (5/16). Where two bands overlap, the
+        // boundary between them is set halfway between their mids.
+    Band *pbands[RF433ANY_MAX_BANDS] = { &b_short, &b_long };
+    byte n = 2;
+    for (byte i = 0; i < nb_extra; ++i)
+        pbands[n++] = &b_extra[i];
+    for (byte i = 0; i < n; ++i) {
+        uint16_t w = (pbands[i]->mid >> 2) + (pbands[i]->mid >> 4);
+        pbands[i]->inf = pbands[i]->mid - w;
+        pbands[i]->sup = pbands[i]->mid + w;
+    }
+    for (byte i = 0; i < n; ++i) {
+        for (byte j = 0; j < n; ++j) {
+            Band *plo = pbands[i];
+            Band *phi = pbands[j];
+            if (plo->mid >= phi->mid || plo->sup < phi->inf)
+                continue;
+            uint16_t m = (plo->mid + phi->mid) >> 1;
+            if (plo->sup > m)
+                plo->sup = m;
+            if (phi->inf <= m)
+                phi->inf = m + 1;
+        }
+    }
+#else
+    set_default_bounds(&b_short, &b_long);
+#endif
+}
+
+#ifdef RF433ANY_MULTI_BANDS
+    // Bands as they are without RF433ANY_MULTI_BANDS, so that the timings of
+    // low and high rails get compared the same way (see
+    // Track::track_eat_recv()).
+void Rail::get_default_bands(Band *pshort, Band *plong) const {
+    pshort->init(b_short.mid);
+    plong->init(b_long.mid);
+    set_default_bounds(pshort, plong);
+}
+#endif
+
+#ifdef RF433ANY_ADAPTIVE_BANDS
+    // Takes into account d, just recorded.
+    // As long as there is one band only, b_short and b_long are the same
+    // (see get_band_count()).
+inline void Rail::adapt_bands(uint16_t d) {
+    if (b_short.mid == b_long.mid) {
+        b_short.add_sample(d);
+        uint16_t w = b_short.get_halfwidth();
+        b_short.inf = b_short.mid - w;
+        b_short.sup = b_short.mid + w;
+        b_long = b_short;
+    } else {
+        (last_bit_recorded ? b_long : b_short).add_sample(d);
+        set_bounds();
+    }
+}
+#endif
+
+#ifdef RF433ANY_MULTI_BANDS
+#define RAIL_SYM_NONE 0xFF
+
+    // Called when d is neither in b_short nor in b_long (both being known).
+    // Returns the symbol of the band d belongs to, RAIL_SYM_NONE if none.
+    // Symbols are 0 for b_short, 1 for b_long and 2 and above for b_extra.
+    // d creates a new band if it is far enough from the bands known.
+    // Otherwise, in RAIL_MOOD_LAXIST mood, d goes to the nearest band, as
+    // long as it is within the range of the default bands (see
+    // set_bounds()).
+byte Rail::eat_extra(uint16_t d) {
+    for (byte i = 0; i < nb_extra; ++i) {
+        if (b_extra[i].test_value(d))
+            return 2 + i;
+    }
+    if (b_sep.mid && b_sep.test_value(d))
+        return RAIL_SYM_NONE;
+
+    uint16_t mids[RF433ANY_MAX_BANDS] = { b_short.mid, b_long.mid };
+    byte n = 2;
+    for (byte i = 0; i < nb_extra; ++i)
+        mids[n++] = b_extra[i].mid;
+
+    byte sym_min = 0;
+    byte sym_max = 0;
+    byte sym_nearest = 0;
+    bool is_far = true;
+    for (byte i = 0; i < n; ++i) {
+        uint16_t m = mids[i];
+            // A new band must be at a ratio of 1.4 or more of every band
+            // known, so that a jittered duration does not create one.
+        if ((unsigned long)d * 5 < (unsigned long)m * 7
+                && (unsigned long)m * 5 < (unsigned long)d * 7) {
+            is_far = false;
+        }
+        if (m < mids[sym_min])
+            sym_min = i;
+        if (m > mids[sym_max])
+            sym_max = i;
+        if ((d > m ? d - m : m - d) < (d > mids[sym_nearest] ?
+                    d - mids[sym_nearest] : mids[sym_nearest] - d)) {
+            sym_nearest = i;
+        }
+    }
+    uint16_t mid_min = mids[sym_min];
+    uint16_t mid_max = mids[sym_max];
+
+        // Same criteria as when b_long gets found (not more than 4 times
+        // the shortest band, and a separator is at least twice the longest
+        // band).
+    if (is_far && nb_extra < RF433ANY_MAX_BANDS - 2 && d < (mid_max << 1)
+            && d <= ((unsigned long)mid_min << 2)
+            && ((unsigned long)d << 2) >= mid_max
+            && b_extra[nb_extra].init(d)) {
+        ++nb_extra;
+        set_bounds();
+#ifdef RF433ANY_DBG_TRACE
+        dbgf("R> new band, mid = %u, band count = %d", d, get_band_count());
+#endif
+        return 1 + nb_extra;
+    }
+
+    if (mood == RAIL_MOOD_LAXIST
+            && d >= (mid_min >> 1) - (mid_min >> 3)
+            && d <= mid_max + (mid_max >> 1) + (mid_max >> 3)) {
+        return sym_nearest;
+    }
+
+    return RAIL_SYM_NONE;
+}
+#endif
+
+inline bool Rail::rail_eat_bands(uint16_t d) {
 #ifdef RF433ANY_DBG_TRACE
     dbgf("R> index = %d, d = %u", index, d);
 #endif
@@ -300,6 +582,11 @@ inline bool Rail::rail_eat(uint16_t d) {
     if (status != RAIL_OPEN)
         return false;
 
+#ifdef RF433ANY_ADAPTIVE_BANDS
+        // No adaptation when d initializes the bands
+    bool adapt = b_short.mid;
+#endif
+
     byte count_got_it = 0;
     if (b_short.test_value_init_if_needed(d))
         ++count_got_it;
@@ -363,15 +650,13 @@ inline bool Rail::rail_eat(uint16_t d) {
 
                     // As we now know who's who (b_short is b_short and b_long
                     // is b_long, yes), we can adjust boundaries accordingly.
-
-                b_short.inf = (b_short.mid >> 1) - (b_short.mid >> 3);
-                if (mood == RAIL_MOOD_LAXIST) {
-                    b_short.sup = (b_short.mid + b_long.mid) >> 1;
-                    b_long.inf = b_short.sup + 1;
-                }
-                b_long.sup = b_long.mid + (b_long.mid >> 1) + (b_long.mid >> 3);
+                set_bounds();
 
                 count_got_it = 1;
+#ifdef RF433ANY_ADAPTIVE_BANDS
+                    // d is already taken into account by init()
+                adapt = false;
+#endif
                 band_count = 2;
 
                     // Test if intervals overlap?
@@ -389,12 +674,23 @@ inline bool Rail::rail_eat(uint16_t d) {
         }
     }
 
+#ifdef RF433ANY_MULTI_BANDS
+    byte extra_sym = RAIL_SYM_NONE;
+    if (band_count >= 2 && !count_got_it) {
+        extra_sym = eat_extra(d);
+        if (extra_sym != RAIL_SYM_NONE) {
+            count_got_it = 1;
+            band_count = get_band_count();
+        }
+    }
+#endif
+
     if (!band_count) {
         status = RAIL_ERROR;
         return false;
     }
 
-    if (!count_got_it || (band_count == 2 && count_got_it == 2)) {
+    if (!count_got_it || (band_count >= 2 && count_got_it == 2)) {
         if (!b_sep.mid) {
                 // BAND_MAX_D is 30000, and multiplying .mid by 2 will produce a
                 // maximum value of 60000, that's OK for an unsigned 16-bit int.
@@ -405,6 +701,10 @@ inline bool Rail::rail_eat(uint16_t d) {
                     // We can end up with an overlap between b_sep and b_long.
                     // Not an issue.
                 b_sep.init_sep(d);
+#ifdef RF433ANY_RAIL_LUT
+                if (lut_ready)
+                    lut_build();
+#endif
             } else {
 #ifdef RF433ANY_DBG_TRACE
                 dbg("R> no init of b_sep (d too small)");
@@ -419,18 +719,38 @@ inline bool Rail::rail_eat(uint16_t d) {
 
     } else {
 
-        if (band_count == 2) {
+        if (band_count >= 2) {
             if (b_short.got_it == b_long.got_it) {
+#ifdef RF433ANY_MULTI_BANDS
+                assert(extra_sym != RAIL_SYM_NONE);
+#else
                 assert(false);
+#endif
             }
             last_bit_recorded = (b_short.got_it ? 0 : 1);
-            rec = (rec << 1) | last_bit_recorded;
+#ifdef RF433ANY_MULTI_BANDS
+            if (extra_sym != RAIL_SYM_NONE)
+                last_bit_recorded = extra_sym;
+                // As long as there is no extra band, rec2 is zero and needs
+                // no shift.
+            if (nb_extra)
+                rec2 = (rec2 << 1) | (last_bit_recorded >> 1);
+#endif
+            rec = (rec << 1) | (last_bit_recorded & 1);
         } else {
             last_bit_recorded = 0;
         }
         if (++index == (sizeof(rec) << 3)) {
             status = RAIL_FULL;
         }
+#ifdef RF433ANY_ADAPTIVE_BANDS
+        if (adapt)
+            adapt_bands(d);
+#endif
+#ifdef RF433ANY_RAIL_LUT
+        if (!lut_ready && band_count == 2 && index >= RAIL_LUT_MIN_BITS)
+            lut_build();
+#endif
 
     }
 
@@ -447,7 +767,8 @@ const char* status_names[] = {
 };
 void Rail::rail_debug() const {
     dbgf("      \"bits\":%i,\"v\":0x" FMTRECORDEDT
-         ",\"railstatus\":\"%s\",\"n\":%d,", index, rec, status_names[status],
+         ",\"railstatus\":\"%s\",\"n\":%d,", index, RECORDEDT_ARG(rec),
+         status_names[status],
          (b_short.mid == b_long.mid ? 1 : 2));
     for (byte i = 0; i < 3; ++i) {
         dbgf("      \"%s\":{\"inf\":%u,\"mid\":%u,\"sup\":%u}%s",
@@ -462,8 +783,48 @@ void Rail::rail_debug() const {
 #endif
 
 byte Rail::get_band_count() const {
+#ifdef RF433ANY_MULTI_BANDS
+    return b_short.mid == b_long.mid ? (b_short.mid ? 1 : 0) : 2 + nb_extra;
+#else
     return b_short.mid == b_long.mid ? (b_short.mid ? 1 : 0) : 2;
+#endif
+}
+
+#ifdef RF433ANY_MULTI_BANDS
+    // Symbols recorded, as ranks of the bands (0 for the shortest).
+    // Recorded symbols are 0 for b_short, 1 for b_long and 2 or more for the
+    // bands found after them: b_extra can have bands shorter than b_long,
+    // or shorter than b_short.
+void Rail::get_symbols(recorded_t *prec, recorded_t *prec2) const {
+    *prec = rec;
+    *prec2 = rec2;
+    if (!nb_extra)
+        return;
+
+    uint16_t mids[RF433ANY_MAX_BANDS] = { b_short.mid, b_long.mid };
+    byte n = 2;
+    for (byte i = 0; i < nb_extra; ++i)
+        mids[n++] = b_extra[i].mid;
+    byte rank[RF433ANY_MAX_BANDS];
+    for (byte i = 0; i < n; ++i) {
+        rank[i] = 0;
+        for (byte j = 0; j < n; ++j) {
+            if (mids[j] < mids[i])
+                ++rank[i];
+        }
+    }
+
+    recorded_t r = 0;
+    recorded_t r2 = 0;
+    for (byte i = 0; i < index; ++i) {
+        byte sym = rank[((rec >> i) & 1) | (((rec2 >> i) & 1) << 1)];
+        r |= (recorded_t)(sym & 1) << i;
+        r2 |= (recorded_t)(sym >> 1) << i;
+    }
+    *prec = r;
+    *prec2 = r2;
 }
+#endif
 
 
 // * **** *********************************************************************
@@ -487,20 +848,144 @@ void RawCode::debug_rawcode() const {
         dbgf("  %02d  %s", i, sts_names[psec->sts]);
         dbgf("      sep = %u", psec->ts.sep);
         dbgf("      low:  [%d] n = %2d, v = 0x" FMTRECORDEDT "",
-                      psec->low_bands, psec->low_bits, psec->low_rec);
+                      psec->low_bands, psec->low_bits,
+                      RECORDEDT_ARG(psec->low_rec));
         dbgf("      high: [%d] n = %2d, v = 0x" FMTRECORDEDT "",
-                      psec->high_bands, psec->high_bits, psec->high_rec);
+                      psec->high_bands, psec->high_bits,
+                      RECORDEDT_ARG(psec->high_rec));
     }
 }
 #endif
 
 
+// * ***** ********************************************************************
+// * Arena ********************************************************************
+// * ***** ********************************************************************
+
+#ifdef RF433ANY_ARENA_SIZE
+
+Arena RF433any_arena;
+
+#define ARENA_ALIGN  alignof(max_align_t)
+
+    // Each block of decoders and data starts with a header, rounded up to
+    // keep blocks aligned. Sizes include the header.
+struct arena_block_t {
+    uint16_t size;
+    uint16_t prev_size; // Size of the block before (0 if none)
+    bool released;
+};
+#define ARENA_HEADER \
+    ((sizeof(arena_block_t) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+static inline size_t arena_round(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+Arena::Arena():
+        top(0),
+        bottom_of_permanent(RF433ANY_ARENA_SIZE & ~(ARENA_ALIGN - 1)),
+        last_size(0) {
+    reset_stats();
+}
+
+void Arena::reset_stats() {
+    stats.max_used = 0;
+    stats.nb_overflows = 0;
+    update_max_used();
+}
+
+inline void Arena::update_max_used() {
+    uint16_t used = top + (RF433ANY_ARENA_SIZE - bottom_of_permanent);
+    if (used > stats.max_used)
+        stats.max_used = used;
+}
+
+void *Arena::alloc(size_t n) {
+    size_t sz = ARENA_HEADER + arena_round(n);
+    if (sz > (size_t)(bottom_of_permanent - top)) {
+        ++stats.nb_overflows;
+        return malloc(n);
+    }
+    arena_block_t *b = (arena_block_t*)(buf.bytes + top);
+    b->size = sz;
+    b->prev_size = last_size;
+    b->released = false;
+    top += sz;
+    last_size = sz;
+    update_max_used();
+    return (byte*)b + ARENA_HEADER;
+}
+
+    // Same as realloc(). The last block gets resized in place.
+void *Arena::resize(void *p, size_t n) {
+    if (!p)
+        return alloc(n);
+    if (!owns(p))
+        return realloc(p, n);
+
+    arena_block_t *b = (arena_block_t*)((byte*)p - ARENA_HEADER);
+    uint16_t pos = (byte*)b - buf.bytes;
+    size_t new_sz = ARENA_HEADER + arena_round(n);
+    if (pos + b->size == top && new_sz <= (size_t)(bottom_of_permanent - pos)) {
+        b->size = new_sz;
+        top = pos + new_sz;
+        last_size = new_sz;
+        update_max_used();
+        return p;
+    }
+    if (new_sz <= b->size)
+        return p;
+
+    void *q = alloc(n);
+    if (q)
+        memcpy(q, p, b->size - ARENA_HEADER);
+    release(p);
+    return q;
+}
+
+    // Same as free(). The space of a block is reused once the blocks that
+    // come after it are released.
+void Arena::release(void *p) {
+    if (!p)
+        return;
+    if (!owns(p)) {
+        free(p);
+        return;
+    }
+    arena_block_t *b = (arena_block_t*)((byte*)p - ARENA_HEADER);
+    assert(!b->released);
+    b->released = true;
+    while (last_size) {
+        b = (arena_block_t*)(buf.bytes + top - last_size);
+        if (!b->released)
+            break;
+        top -= last_size;
+        last_size = b->prev_size;
+    }
+}
+
+    // Returns space that is never released, taken from the end of the buffer
+void *Arena::alloc_permanent(size_t n) {
+    size_t sz = arena_round(n);
+    if (sz > (size_t)(bottom_of_permanent - top)) {
+        ++stats.nb_overflows;
+        return malloc(n);
+    }
+    bottom_of_permanent -= sz;
+    update_max_used();
+    return buf.bytes + bottom_of_permanent;
+}
+
+#endif // RF433ANY_ARENA_SIZE
+
+
 // * ********* ****************************************************************
 // * BitVector ****************************************************************
 // * ********* ****************************************************************
 
 BitVector::BitVector():
-        array(nullptr),
+        words(nullptr),
         allocated(0),
         nb_bits(0) {
 
@@ -511,112 +996,230 @@ void BitVector::prepare_BitVector_construction(short arg_nb_bits,
     assert(arg_nb_bits > 0);
     assert((arg_nb_bits + 7) >> 3 == arg_nb_bytes);
     assert(arg_nb_bytes == n);
-    array = (uint8_t*)malloc(arg_nb_bytes);
-    allocated = arg_nb_bytes;
-    nb_bits = arg_nb_bits;
+    reserve(arg_nb_bits);
+}
+
+    // Adds the n bytes of b, b[0] being the most significant one: it carries
+    // the bits of arg_nb_bits that do not fill a byte.
+void BitVector::add_bytes(short arg_nb_bits, const byte *b, byte n) {
+    byte nb_first = arg_nb_bits - ((n - 1) << 3);
+    add_bits(b[0] & ((1 << nb_first) - 1), nb_first);
+    for (byte i = 1; i < n; ++i)
+        add_bits(b[i], 8);
 }
 
 BitVector::BitVector(short arg_nb_bits, short arg_nb_bytes, byte b0,
-        byte b1) {
+        byte b1): BitVector() {
     prepare_BitVector_construction(arg_nb_bits, arg_nb_bytes, 2);
-    array[1] = b0;
-    array[0] = b1;
+    const byte b[] = { b0, b1 };
+    add_bytes(arg_nb_bits, b, 2);
 }
 
 BitVector::BitVector(short arg_nb_bits, short arg_nb_bytes, byte b0, byte b1,
-        byte b2) {
+        byte b2): BitVector() {
     prepare_BitVector_construction(arg_nb_bits, arg_nb_bytes, 3);
-    array[2] = b0;
-    array[1] = b1;
-    array[0] = b2;
+    const byte b[] = { b0, b1, b2 };
+    add_bytes(arg_nb_bits, b, 3);
 }
 
 BitVector::BitVector(short arg_nb_bits, short arg_nb_bytes, byte b0, byte b1,
-        byte b2, byte b3) {
+        byte b2, byte b3): BitVector() {
     prepare_BitVector_construction(arg_nb_bits, arg_nb_bytes, 4);
-    array[3] = b0;
-    array[2] = b1;
-    array[1] = b2;
-    array[0] = b3;
+    const byte b[] = { b0, b1, b2, b3 };
+    add_bytes(arg_nb_bits, b, 4);
 }
 
 BitVector::BitVector(short arg_nb_bits, short arg_nb_bytes, byte b0, byte b1,
-        byte b2, byte b3, byte b4) {
+        byte b2, byte b3, byte b4): BitVector() {
     prepare_BitVector_construction(arg_nb_bits, arg_nb_bytes, 5);
-    array[4] = b0;
-    array[3] = b1;
-    array[2] = b2;
-    array[1] = b3;
-    array[0] = b4;
+    const byte b[] = { b0, b1, b2, b3, b4 };
+    add_bytes(arg_nb_bits, b, 5);
 }
 
 BitVector::BitVector(short arg_nb_bits, short arg_nb_bytes, byte b0, byte b1,
-        byte b2, byte b3, byte b4, byte b5) {
+        byte b2, byte b3, byte b4, byte b5): BitVector() {
     prepare_BitVector_construction(arg_nb_bits, arg_nb_bytes, 6);
-    array[5] = b0;
-    array[4] = b1;
-    array[3] = b2;
-    array[2] = b3;
-    array[1] = b4;
-    array[0] = b5;
+    const byte b[] = { b0, b1, b2, b3, b4, b5 };
+    add_bytes(arg_nb_bits, b, 6);
 }
 
 BitVector::~BitVector() {
-    if (array)
-        free(array);
+    if (words)
+        free_words();
 }
 
-void BitVector::add_bit(byte v) {
-    if (!allocated)
-        array = (uint8_t*)malloc(1);
-    if (nb_bits >= (allocated << 3)) {
-        byte old_allocated = allocated;
-
-            // FIXME
-        ++allocated;    // Could be another formula ('<<= 1', ...)
+    // Same as realloc() and free() on words, in RF433any_arena if this
+    // BitVector is.
+void *BitVector::realloc_words(size_t sz) {
+#ifdef RF433ANY_ARENA_SIZE
+    if (RF433any_arena.owns(this))
+        return RF433any_arena.resize(words, sz);
+#endif
+    return realloc(words, sz);
+}
 
-        array = (uint8_t*)realloc(array, allocated);
-        for (byte i = old_allocated; i < allocated; ++i)
-            array[i] = 0;
+void BitVector::free_words() {
+#ifdef RF433ANY_ARENA_SIZE
+    if (RF433any_arena.owns(this)) {
+        RF433any_arena.release(words);
+        return;
     }
+#endif
+    free(words);
+}
 
-    ++nb_bits;
-    for (short i = allocated - 1; i >= 0; --i) {
-
-        byte b;
-        if (i > 0) {
-            b = !!(array[i - 1] & 0x80);
-        } else {
-                // Defensive programming:
-                //   Normally v is 0 or 1, but I normalize it, just in case.
-            b = !!v;
-        }
+    // Makes room for n bits, doubling the storage as many times as needed
+void BitVector::reserve(uint16_t n) {
+    uint16_t needed = (n + BITVECTOR_WORD_BITS - 1) / BITVECTOR_WORD_BITS;
+    if (needed <= allocated)
+        return;
+    uint16_t new_allocated = (allocated ? allocated : BITVECTOR_MIN_WORDS);
+    while (new_allocated < needed)
+        new_allocated <<= 1;
+        // allocated is a byte: with 1-byte words (AVR), doubling 128 words
+        // would give 256, whereas up to 255 can be used.
+    if (new_allocated > 255 && needed <= 255)
+        new_allocated = 255;
+    assert(new_allocated <= 255);
+
+    words = (bitvector_word_t*)realloc_words(
+            new_allocated * sizeof(bitvector_word_t));
+    for (byte i = allocated; i < new_allocated; ++i)
+        words[i] = 0;
+    allocated = new_allocated;
+}
 
-        array[i]= (array[i] << 1) | b;
+void BitVector::add_bit(byte v) {
+    reserve(nb_bits + 1);
+        // Defensive programming:
+        //   Normally v is 0 or 1, but I normalize it, just in case.
+    if (v) {
+        words[nb_bits / BITVECTOR_WORD_BITS] |= (bitvector_word_t)1
+            << (BITVECTOR_WORD_BITS - 1 - nb_bits % BITVECTOR_WORD_BITS);
+    }
+    ++nb_bits;
+}
 
+    // Same as add_bit() called for the n least significant bits of v, most
+    // significant first.
+void BitVector::add_bits(recorded_t v, byte n) {
+    reserve(nb_bits + n);
+    while (n) {
+        byte room = BITVECTOR_WORD_BITS - nb_bits % BITVECTOR_WORD_BITS;
+        byte c = (n < room ? n : room);
+        n -= c;
+        bitvector_word_t chunk = (bitvector_word_t)(v >> n);
+        if (c < BITVECTOR_WORD_BITS)
+            chunk &= ((bitvector_word_t)1 << c) - 1;
+        words[nb_bits / BITVECTOR_WORD_BITS] |= chunk << (room - c);
+        nb_bits += c;
     }
 }
 
-int BitVector::get_nb_bits() const {
-    return nb_bits;
+    // Returns the len bits (32 at most) that got added from the first-th one
+    // on (first counting from 0), the first one being the most significant.
+    // Bits before the first one added (first being negative) are 0.
+uint32_t BitVector::get_bits(int first, byte len) const {
+    assert(len <= 32);
+    int end = first + len;
+    int i = (first < 0 ? 0 : first);
+    uint32_t r = 0;
+    while (i < end) {
+        byte room = BITVECTOR_WORD_BITS - i % BITVECTOR_WORD_BITS;
+        byte c = (end - i < room ? end - i : room);
+        bitvector_word_t w = words[i / BITVECTOR_WORD_BITS] >> (room - c);
+        if (c < BITVECTOR_WORD_BITS)
+            w &= ((bitvector_word_t)1 << c) - 1;
+        r = (c < 32 ? r << c : 0) | w;
+        i += c;
+    }
+    return r;
 }
 
-byte BitVector::get_nb_bytes() const {
-    return (nb_bits + 7) >> 3;
+    // Bit numbering starts at 0
+byte BitVector::get_nth_bit(uint16_t n) const {
+    assert(n < nb_bits);
+    uint16_t i = nb_bits - 1 - n;
+    return (words[i / BITVECTOR_WORD_BITS]
+            >> (BITVECTOR_WORD_BITS - 1 - i % BITVECTOR_WORD_BITS)) & 1;
 }
 
     // Bit numbering starts at 0
-byte BitVector::get_nth_bit(byte n) const {
-    assert(n >= 0 && n < nb_bits);
-    byte index = (n >> 3);
-    byte bitread = (1 << (n & 0x07));
-    return !!(array[index] & bitread);
+void BitVector::set_nth_bit(uint16_t n, byte v) {
+    assert(n < nb_bits);
+    uint16_t i = nb_bits - 1 - n;
+    bitvector_word_t m = (bitvector_word_t)1
+        << (BITVECTOR_WORD_BITS - 1 - i % BITVECTOR_WORD_BITS);
+    if (v)
+        words[i / BITVECTOR_WORD_BITS] |= m;
+    else
+        words[i / BITVECTOR_WORD_BITS] &= ~m;
 }
 
     // Bit numbering starts at 0
-byte BitVector::get_nth_byte(byte n) const {
-    assert(n >= 0 && n < get_nb_bytes());
-    return array[n];
+byte BitVector::get_nth_byte(uint16_t n) const {
+    assert(n < get_nb_bytes());
+    return get_bits((int)nb_bits - ((n + 1) << 3), 8);
+}
+
+    // The 32 (or 64) bits last added, as an integer, missing bits being 0
+uint32_t BitVector::get_uint32() const {
+    return get_bits((int)nb_bits - 32, 32);
+}
+
+    // Equal for two BitVector objects that cmp() says are equal.
+    // With pmask (having as many bits as this BitVector), only the bits set in
+    // *pmask are taken into account: equal for two BitVector objects that
+    // matches() says are equal.
+uint32_t BitVector::get_hash(const BitVector *pmask) const {
+    assert(!pmask || pmask->nb_bits == nb_bits);
+    uint32_t h = 2166136261UL ^ nb_bits;
+    uint16_t nb_words =
+        (nb_bits + BITVECTOR_WORD_BITS - 1) / BITVECTOR_WORD_BITS;
+    for (uint16_t i = 0; i < nb_words; ++i)
+        h = (h ^ (pmask ? words[i] & pmask->words[i] : words[i])) * 16777619UL;
+        // The multiplications carry bits to the left only, whereas the index
+        // of a bucket is taken from the right, and the bits of a short code
+        // are on the left of its word: all bits are mixed (finalization of
+        // MurmurHash3).
+    h ^= h >> 16;
+    h *= 0x85ebca6bUL;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35UL;
+    return h ^ (h >> 16);
+}
+
+uint64_t BitVector::get_uint64() const {
+    return ((uint64_t)get_bits((int)nb_bits - 64, 32) << 32)
+           | get_bits((int)nb_bits - 32, 32);
+}
+
+    // Returns true if this BitVector has as many bits as *pvalue and *pmask
+    // and the same bits as *pvalue where *pmask has bits set.
+bool BitVector::matches(const BitVector *pvalue, const BitVector *pmask) const {
+    assert(pvalue && pmask);
+    if (nb_bits != pvalue->nb_bits || nb_bits != pmask->nb_bits)
+        return false;
+    uint16_t nb_words =
+        (nb_bits + BITVECTOR_WORD_BITS - 1) / BITVECTOR_WORD_BITS;
+    for (uint16_t i = 0; i < nb_words; ++i) {
+        if ((words[i] ^ pvalue->words[i]) & pmask->words[i])
+            return false;
+    }
+    return true;
+}
+
+    // Number of bits that differ (Hamming distance), *p having as many bits
+uint16_t BitVector::distance(const BitVector *p) const {
+    assert(p && p->nb_bits == nb_bits);
+    uint16_t d = 0;
+    uint16_t nb_words =
+        (nb_bits + BITVECTOR_WORD_BITS - 1) / BITVECTOR_WORD_BITS;
+    for (uint16_t i = 0; i < nb_words; ++i) {
+        for (bitvector_word_t x = words[i] ^ p->words[i]; x; x &= x - 1)
+            ++d;
+    }
+    return d;
 }
 
     // *IMPORTANT*
@@ -634,7 +1237,7 @@ char* BitVector::to_str() const {
     if (!get_nb_bits())
         return nullptr;
 
-    byte nb_bytes = get_nb_bytes();
+    uint16_t nb_bytes = get_nb_bytes();
 
     char *ret = (char*)malloc(nb_bytes * 3);
     char tmp[3];
@@ -660,12 +1263,13 @@ short BitVector::cmp(const BitVector *p) const {
     if (cmp_nb_bits)
         return cmp_nb_bits;
 
-    for (int i = get_nb_bits() - 1; i >= 0; --i) {
-        byte v1 = get_nth_bit(i);
-        byte v2 = p->get_nth_bit(i);
-        if (v1 > v2)
+        // Bits after the last one being 0, comparing words compares bits
+    uint16_t nb_words =
+        (nb_bits + BITVECTOR_WORD_BITS - 1) / BITVECTOR_WORD_BITS;
+    for (uint16_t i = 0; i < nb_words; ++i) {
+        if (words[i] > p->words[i])
             return 1;
-        if (v1 < v2)
+        if (words[i] < p->words[i])
             return -1;
     }
 
@@ -684,13 +1288,20 @@ const char *dec_id_names[] = {
     "TRI",
     "TRN",
     "MAN",
-    "UNK"
+    "UNK",
+    "MWI"
 };
 #endif
 
 Decoder::Decoder(byte arg_convention):
         next(nullptr),
+        repeats(0),
+        confidence(100),
+#ifdef RF433ANY_ARENA_SIZE
+        pdata(new (RF433any_arena) BitVector()),
+#else
         pdata(new BitVector()),
+#endif
         convention(arg_convention),
         nb_errors(0) {
     tsext.initseq = 0;
@@ -738,6 +1349,10 @@ void Decoder::add_data_bit(byte valbit) {
     pdata->add_bit(valbit);
 }
 
+void Decoder::add_data_bits(recorded_t bits, byte n) {
+    pdata->add_bits(bits, n);
+}
+
 byte Decoder::get_nb_errors() const { return nb_errors; }
 
 int Decoder::get_nb_bits() const { return pdata ? pdata->get_nb_bits() : 0; }
@@ -758,17 +1373,13 @@ void Decoder::get_tsext(TimingsExt *p_tsext) const {
     p_tsext->first_low_ignored = first_lo_ignored();
 }
 
-void Decoder::take_into_account_first_low_high(const Section *psec,
-        bool is_cont_of_prev_sec) {
-    tsext.last_low = psec->last_low;
-    if (is_cont_of_prev_sec)
-        return;
-    tsext.first_low = psec->first_low;
-    tsext.first_high = psec->first_high;
-
+    // Tells whether the first low and high of a section make a signal step
+    // (both being short or long), and if so, gives it.
+bool Decoder::first_signal_step(const Section *psec, Signal *plo,
+        Signal *phi) {
     Signal e[2];
     for (short i = 0; i < 2; ++i) {
-        uint16_t d = (i == 0 ? tsext.first_low : tsext.first_high);
+        uint16_t d = (i == 0 ? psec->first_low : psec->first_high);
         uint16_t short_d = (i == 0 ? psec->ts.low_short : psec->ts.high_short);
         uint16_t long_d = (i == 0 ? psec->ts.low_long : psec->ts.high_long);
         Band b_short;
@@ -793,8 +1404,23 @@ void Decoder::take_into_account_first_low_high(const Section *psec,
         }
     }
 
-    if (e[0] != Signal::OTHER && e[1] != Signal::OTHER) {
-        add_signal_step(e[0], e[1]);
+    *plo = e[0];
+    *phi = e[1];
+    return (e[0] != Signal::OTHER && e[1] != Signal::OTHER);
+}
+
+void Decoder::take_into_account_first_low_high(const Section *psec,
+        bool is_cont_of_prev_sec) {
+    tsext.last_low = psec->last_low;
+    if (is_cont_of_prev_sec)
+        return;
+    tsext.first_low = psec->first_low;
+    tsext.first_high = psec->first_high;
+
+    Signal lo;
+    Signal hi;
+    if (first_signal_step(psec, &lo, &hi)) {
+        add_signal_step(lo, hi);
         tsext.first_low = 0;
         tsext.first_high = 0;
     }
@@ -802,28 +1428,58 @@ void Decoder::take_into_account_first_low_high(const Section *psec,
 
 void Decoder::decode_section(const Section *psec, bool is_cont_of_prev_sec) {
     take_into_account_first_low_high(psec, is_cont_of_prev_sec);
+    decode_rec(psec);
+}
+
+    // Calls add_signal_step() for the signal step of psec made of the low at
+    // position *ppos_low - 1 and the high at position *ppos_high - 1
+    // (positions count from the least significant bit of low_rec and
+    // high_rec, 0 meaning there is no more signal), and moves to the next
+    // one.
+inline void Decoder::add_signal_step_at(const Section *psec, byte *ppos_low,
+        byte *ppos_high) {
+    Signal sd_low = Signal::OTHER;
+    Signal sd_high = Signal::OTHER;
+    if (*ppos_low >= 1) {
+        --*ppos_low;
+        sd_low = ((((recorded_t)1 << *ppos_low) & psec->low_rec) ?
+                    Signal::LONG : Signal::SHORT);
+    }
+    if (*ppos_high >= 1) {
+        --*ppos_high;
+        sd_high =
+            ((((recorded_t)1 << *ppos_high) & psec->high_rec) ?
+            Signal::LONG : Signal::SHORT);
+    }
+    add_signal_step(sd_low, sd_high);
+}
 
-    byte pos_low = psec->low_bits;
-    byte pos_high = psec->high_bits;
+    // Calls add_signal_step() for the signal steps of psec, starting at
+    // positions pos_low and pos_high (see add_signal_step_at()).
+void Decoder::add_signal_steps(const Section *psec, byte pos_low,
+        byte pos_high) {
+    while (pos_low >= 1 || pos_high >= 1)
+        add_signal_step_at(psec, &pos_low, &pos_high);
+}
 
-    while (pos_low >= 1 || pos_high >= 1) {
-        Signal sd_low = Signal::OTHER;
-        Signal sd_high = Signal::OTHER;
-        if (pos_low >= 1) {
-            --pos_low;
-            sd_low = ((((recorded_t)1 << pos_low) & psec->low_rec) ?
-                        Signal::LONG : Signal::SHORT);
-        }
-        if (pos_high >= 1) {
-            --pos_high;
-            sd_high =
-                ((((recorded_t)1 << pos_high) & psec->high_rec) ?
-                Signal::LONG : Signal::SHORT);
-        }
-        add_signal_step(sd_low, sd_high);
-    }
+    // Decodes the recorded signal steps of psec (the first low and high of
+    // the section being already taken into account).
+void Decoder::decode_rec(const Section *psec) {
+    add_signal_steps(psec, psec->low_bits, psec->high_bits);
 }
 
+#ifdef RF433ANY_DBG_SIMULATE
+    // Checks the data bits added since there were nb_bits_before of them, are
+    // the ones of pref, that decoded the same signal steps one at a time.
+void Decoder::dbg_check_same_bits(const Decoder *pref,
+        int nb_bits_before) const {
+    int n = pref->pdata->get_nb_bits();
+    assert(pdata->get_nb_bits() == nb_bits_before + n);
+    for (int i = 0; i < n; ++i)
+        assert(pdata->get_nth_bit(i) == pref->pdata->get_nth_bit(i));
+}
+#endif
+
 uint16_t Decoder::first_lo_ignored() const {
     return 0;
 }
@@ -832,6 +1488,42 @@ const BitVector* Decoder::get_pdata() const {
     return pdata;
 }
 
+    // Replaces the data with the bitwise majority of the data of this decoder
+    // and of the nb - 1 ones that follow it (having as many bits), each one
+    // counting for as many copies as it has (get_repeats() + 1). In case of a
+    // tie, the bit of this decoder is kept.
+    // The number of copies gets summed up in the repeats, and the confidence
+    // is the percentage of copies that agree with the result, on the bit where
+    // they agree the least.
+void Decoder::vote(byte nb) {
+    uint16_t nb_copies = 0;
+    const Decoder *pdec = this;
+    for (byte i = 0; i < nb; ++i, pdec = pdec->next) {
+        assert(pdec && pdec->pdata);
+        assert(pdec->pdata->get_nb_bits() == pdata->get_nb_bits());
+        nb_copies += pdec->repeats + 1;
+    }
+
+    uint16_t min_agree = nb_copies;
+    for (int n = 0; n < pdata->get_nb_bits(); ++n) {
+        uint16_t nb_ones = 0;
+        pdec = this;
+        for (byte i = 0; i < nb; ++i, pdec = pdec->next) {
+            if (pdec->pdata->get_nth_bit(n))
+                nb_ones += pdec->repeats + 1;
+        }
+        uint16_t nb_zeros = nb_copies - nb_ones;
+        if (nb_ones != nb_zeros)
+            pdata->set_nth_bit(n, nb_ones > nb_zeros);
+        uint16_t agree = (nb_ones > nb_zeros ? nb_ones : nb_zeros);
+        if (agree < min_agree)
+            min_agree = agree;
+    }
+
+    confidence = (byte)((min_agree * 100UL) / nb_copies);
+    repeats = (nb_copies > 256 ? 255 : nb_copies - 1);
+}
+
 BitVector* Decoder::take_away_data() {
     if (pdata) {
         BitVector *ret = pdata;
@@ -1007,6 +1699,13 @@ void DecoderRawUnknownCoding::dbg_decoder(byte disp_level, byte seq) const {
 #endif
 
 
+    // The n least significant bits set
+static inline recorded_t rec_mask(byte n) {
+    return (n >= (sizeof(recorded_t) << 3) ? ~(recorded_t)0
+                                            : ((recorded_t)1 << n) - 1);
+}
+
+
 // * ************* ************************************************************
 // * DecoderTriBit ************************************************************
 // * ************* ************************************************************
@@ -1028,6 +1727,41 @@ void DecoderTriBit::add_signal_step(Signal lo, Signal hi) {
     add_data_bit(valbit);
 }
 
+#ifndef RF433ANY_DBG_NO_WORD_DECODING
+    // Same as add_signal_step() for each signal step, done on words: a step
+    // is valid if its low and high bits differ, and the data bit is the low
+    // one (inverted with RF433ANY_CONV1).
+    // A last low without high (terminated by a separator) is ignored, as
+    // add_signal_step() does.
+void DecoderTriBit::decode_rec(const Section *psec) {
+    byte n = psec->high_bits;
+    if (psec->low_bits != n && psec->low_bits != n + 1) {
+        Decoder::decode_rec(psec);
+        return;
+    }
+    recorded_t mask = rec_mask(n);
+    recorded_t lo = (psec->low_rec >> (psec->low_bits - n)) & mask;
+    if ((lo ^ (psec->high_rec & mask)) != mask) {
+        Decoder::decode_rec(psec);
+        return;
+    }
+
+#ifdef RF433ANY_DBG_SIMULATE
+    int nb_bits_before = pdata->get_nb_bits();
+#endif
+
+    if (n)
+        add_data_bits(convention ? ~lo & mask : lo, n);
+
+#ifdef RF433ANY_DBG_SIMULATE
+    DecoderTriBit ref(convention);
+    ref.Decoder::decode_rec(psec);
+    assert(!ref.nb_errors);
+    dbg_check_same_bits(&ref, nb_bits_before);
+#endif
+}
+#endif
+
 #ifdef RF433ANY_DBG_DECODER
 void DecoderTriBit::dbg_decoder(byte disp_level, byte seq) const {
     dbg_data(seq);
@@ -1066,6 +1800,64 @@ void DecoderTriBitInv::add_signal_step(Signal lo, Signal hi) {
     last_hi = hi;
 }
 
+#ifndef RF433ANY_DBG_NO_WORD_DECODING
+    // Same as add_signal_step() for each signal step, done on words: each
+    // low is paired with the high of the previous step, a pair being valid
+    // if its bits differ, and the data bit is the low one inverted
+    // (not inverted with RF433ANY_CONV1).
+void DecoderTriBitInv::decode_rec(const Section *psec) {
+    byte pos_low = psec->low_bits;
+    byte pos_high = psec->high_bits;
+    if (pos_low != pos_high && pos_low != pos_high + 1) {
+        Decoder::decode_rec(psec);
+        return;
+    }
+        // The first step gives the initial low (not part of data) and the
+        // first high.
+    if (first_call_to_add_sgn_lo_hi && pos_low)
+        add_signal_step_at(psec, &pos_low, &pos_high);
+
+    byte m = pos_low;
+    if (!m)
+        return;
+    if (last_hi == Signal::OTHER) {
+        add_signal_steps(psec, pos_low, pos_high);
+        return;
+    }
+
+    recorded_t mask = rec_mask(m);
+    recorded_t lo = psec->low_rec & mask;
+        // High of the previous step, for each low
+    recorded_t prev_hi = (psec->high_rec >> (pos_high - (m - 1)))
+                         & rec_mask(m - 1);
+    if (last_hi == Signal::LONG)
+        prev_hi |= (recorded_t)1 << (m - 1);
+    if ((lo ^ prev_hi) != mask) {
+        add_signal_steps(psec, pos_low, pos_high);
+        return;
+    }
+
+#ifdef RF433ANY_DBG_SIMULATE
+    int nb_bits_before = pdata->get_nb_bits();
+    DecoderTriBitInv ref(convention);
+    ref.first_call_to_add_sgn_lo_hi = false;
+    ref.last_hi = last_hi;
+#endif
+
+    add_data_bits(convention ? lo : ~lo & mask, m);
+    if (pos_high == m)
+        last_hi = (psec->high_rec & 1 ? Signal::LONG : Signal::SHORT);
+    else
+        last_hi = Signal::OTHER;
+
+#ifdef RF433ANY_DBG_SIMULATE
+    ref.add_signal_steps(psec, pos_low, pos_high);
+    assert(!ref.nb_errors && ref.last_hi == last_hi);
+    dbg_check_same_bits(&ref, nb_bits_before);
+#endif
+}
+#endif
+
 uint16_t DecoderTriBitInv::first_lo_ignored() const {
     switch (unused_initial_low) {
         case Signal::OTHER:
@@ -1144,6 +1936,96 @@ void DecoderManchester::add_signal_step(Signal lo, Signal hi) {
     }
 }
 
+#ifndef RF433ANY_DBG_NO_WORD_DECODING
+    // What a signal step gives, indexed by (pending << 2) | (low << 1) | high
+    // (a signal being 1 if long, pending being the number of half-bits left
+    // in buf before the step, that is, 1 or 0):
+    //   bits 0-1: number of data bits (MAN_STEP_ERROR if an error)
+    //   bit 2:    pending after the step
+    //   bits 3-4: data bits (RF433ANY_CONV0)
+    // With a pending half-bit, it is a high (1) and the low of the step
+    // completes it: 10, that is, data bit 1.
+#define MAN_STEP_ERROR 3
+const byte man_steps[] = {
+    0x01,           // No pending, short low short high:   01
+    0x05,           // No pending, short low long high:    01 1
+    MAN_STEP_ERROR, // No pending, long low short high:    00 1
+    MAN_STEP_ERROR, // No pending, long low long high:     00 11
+    0x0D,           // Pending, short low short high:   1 0 1 -> 10 1
+    MAN_STEP_ERROR, // Pending, short low long high:    1 0 11 -> 10 11
+    0x12,           // Pending, long low short high:    1 00 1 -> 10 01
+    0x16            // Pending, long low long high:     1 00 11 -> 10 01 1
+};
+
+    // Same as add_signal_step() for each signal step, using man_steps[] and
+    // adding data bits a word at a time.
+    // A high missing (last low terminated by a separator) counts as short,
+    // as in add_signal_step().
+void DecoderManchester::decode_rec(const Section *psec) {
+    byte pos_low = psec->low_bits;
+    byte pos_high = psec->high_bits;
+    if (pos_low != pos_high && pos_low != pos_high + 1) {
+        Decoder::decode_rec(psec);
+        return;
+    }
+        // The leading low-then-high is not part of data
+    if (!leading_lo_hi_has_been_passed && pos_low)
+        add_signal_step_at(psec, &pos_low, &pos_high);
+    if (!leading_lo_hi_has_been_passed || (buf_pos && !buf[0])) {
+        add_signal_steps(psec, pos_low, pos_high);
+        return;
+    }
+
+#ifdef RF433ANY_DBG_SIMULATE
+    int nb_bits_before = pdata->get_nb_bits();
+    byte nb_errors_before = nb_errors;
+    DecoderManchester ref(convention);
+    ref.leading_lo_hi_has_been_passed = true;
+    ref.buf_pos = buf_pos;
+    ref.buf[0] = buf[0];
+    ref.add_signal_steps(psec, pos_low, pos_high);
+#endif
+
+    const byte acc_max = (sizeof(recorded_t) << 3) - 2;
+    byte pending = buf_pos;
+    recorded_t acc = 0;
+    byte nb = 0;
+    while (pos_low) {
+        byte lo = (psec->low_rec >> (pos_low - 1)) & 1;
+        byte hi = (pos_high ? (psec->high_rec >> (pos_high - 1)) & 1 : 0);
+        byte e = man_steps[(pending << 2) | (lo << 1) | hi];
+        byte n = e & 0x03;
+        if (n == MAN_STEP_ERROR)
+            break;
+        acc = (acc << n) | (e >> 3);
+        nb += n;
+        pending = (e >> 2) & 1;
+        --pos_low;
+        if (pos_high)
+            --pos_high;
+        if (nb >= acc_max) {
+            add_data_bits(convention ? ~acc & rec_mask(nb) : acc, nb);
+            acc = 0;
+            nb = 0;
+        }
+    }
+    if (nb)
+        add_data_bits(convention ? ~acc & rec_mask(nb) : acc, nb);
+    buf_pos = pending;
+    if (pending)
+        buf[0] = 1;
+
+        // From the first step in error, if any, one step at a time
+    add_signal_steps(psec, pos_low, pos_high);
+
+#ifdef RF433ANY_DBG_SIMULATE
+    assert(nb_errors - nb_errors_before == ref.nb_errors);
+    assert(buf_pos == ref.buf_pos && (!buf_pos || buf[0] == ref.buf[0]));
+    dbg_check_same_bits(&ref, nb_bits_before);
+#endif
+}
+#endif
+
 #ifdef RF433ANY_DBG_DECODER
 void DecoderManchester::dbg_decoder(byte disp_level, byte seq) const {
     dbg_data(seq);
@@ -1153,12 +2035,367 @@ void DecoderManchester::dbg_decoder(byte disp_level, byte seq) const {
 #endif
 
 
-// * ***** ********************************************************************
-// * Track ********************************************************************
-// * ***** ********************************************************************
+#ifdef RF433ANY_MULTI_BANDS
 
-#ifdef RF433ANY_DBG_SIMULATE
-RF433SerialLine sl;
+// * ***************** ********************************************************
+// * DecoderMultiWidth ********************************************************
+// * ***************** ********************************************************
+
+inline void DecoderMultiWidth::add_symbol(recorded_t rec, recorded_t rec2,
+        byte pos) {
+    add_data_bit(((rec2 >> pos) & 1) ? 1 : 0);
+    add_data_bit(((rec >> pos) & 1) ? 1 : 0);
+}
+
+void DecoderMultiWidth::decode_section(const Section *psec,
+        bool is_cont_of_prev_sec) {
+    tsext.last_low = psec->last_low;
+    if (!is_cont_of_prev_sec) {
+        tsext.first_low = psec->first_low;
+        tsext.first_high = psec->first_high;
+    }
+
+    byte pos_low = (psec->low_bands >= 2 ? psec->low_bits : 0);
+    byte pos_high = (psec->high_bands >= 2 ? psec->high_bits : 0);
+
+    while (pos_low >= 1 || pos_high >= 1) {
+        if (pos_low >= 1)
+            add_symbol(psec->low_rec, psec->low_rec2, --pos_low);
+        if (pos_high >= 1)
+            add_symbol(psec->high_rec, psec->high_rec2, --pos_high);
+    }
+}
+
+#ifdef RF433ANY_DBG_DECODER
+void DecoderMultiWidth::dbg_decoder(byte disp_level, byte seq) const {
+    dbg_data(seq);
+    dbg_meta(disp_level);
+    dbg_next(disp_level, seq);
+}
+#endif
+
+#endif // RF433ANY_MULTI_BANDS
+
+
+// * ************ *************************************************************
+// * DecoderProbe *************************************************************
+// * ************ *************************************************************
+
+void DecoderProbe::init() {
+    failed = 0;
+    sync_shape_set = false;
+    tbi_first_step = true;
+    man_buf_pos = 0;
+    man_leading_passed = false;
+}
+
+    // Same as DecoderManchester::add_buf() then consume_buf()
+inline void DecoderProbe::man_add_buf(byte r) {
+    assert(man_buf_pos < sizeof(man_buf) / sizeof(*man_buf));
+    man_buf[man_buf_pos++] = r;
+    if (man_buf_pos < 2)
+        return;
+    if (man_leading_passed) {
+        if (man_buf[0] == man_buf[1])
+            fail(RF433ANY_ID_MANCHESTER);
+    } else {
+        if (man_buf[0] != 0 || man_buf[1] != 1)
+            fail(RF433ANY_ID_MANCHESTER);
+        man_leading_passed = true;
+    }
+    man_buf[0] = man_buf[2];
+    man_buf_pos -= 2;
+}
+
+    // Errors as counted by add_signal_step() of each decoder
+void DecoderProbe::add_signal_step(Signal lo, Signal hi) {
+    if (!has_failed(RF433ANY_ID_RAW_SYNC)) {
+        if (!sync_shape_set) {
+            sync_shape = lo;
+            sync_shape_set = true;
+        }
+        if (lo != sync_shape || (hi != Signal::OTHER && lo != hi))
+            fail(RF433ANY_ID_RAW_SYNC);
+    }
+
+    if (hi != Signal::OTHER && (lo == hi || lo == Signal::OTHER))
+        fail(RF433ANY_ID_TRIBIT);
+
+    if (!has_failed(RF433ANY_ID_TRIBIT_INV)) {
+        if (tbi_first_step)
+            tbi_first_step = false;
+        else if (lo == Signal::OTHER || lo == tbi_last_hi
+                 || tbi_last_hi == Signal::OTHER)
+            fail(RF433ANY_ID_TRIBIT_INV);
+        tbi_last_hi = hi;
+    }
+
+    if (!has_failed(RF433ANY_ID_MANCHESTER)) {
+        if (lo == Signal::OTHER) {
+            fail(RF433ANY_ID_MANCHESTER);
+        } else {
+            for (byte i = 0; i < 2; ++i) {
+                Signal sgn = (i == 0 ? lo : hi);
+                man_add_buf(i);
+                if (sgn == Signal::LONG)
+                    man_add_buf(i);
+            }
+        }
+    }
+}
+
+    // Returns the id of the decoder to build for psec (psec not being the
+    // continuation of a previous section).
+byte DecoderProbe::probe_section(const Section *psec) {
+    const byte all_failed = (1 << RF433ANY_ID_RAW_SYNC)
+                            | (1 << RF433ANY_ID_TRIBIT)
+                            | (1 << RF433ANY_ID_TRIBIT_INV)
+                            | (1 << RF433ANY_ID_MANCHESTER);
+    init();
+
+    Signal lo;
+    Signal hi;
+    if (Decoder::first_signal_step(psec, &lo, &hi))
+        add_signal_step(lo, hi);
+
+    byte pos_low = psec->low_bits;
+    byte pos_high = psec->high_bits;
+
+    while ((pos_low >= 1 || pos_high >= 1) && failed != all_failed) {
+        lo = Signal::OTHER;
+        hi = Signal::OTHER;
+        if (pos_low >= 1) {
+            --pos_low;
+            lo = ((((recorded_t)1 << pos_low) & psec->low_rec) ?
+                        Signal::LONG : Signal::SHORT);
+        }
+        if (pos_high >= 1) {
+            --pos_high;
+            hi = ((((recorded_t)1 << pos_high) & psec->high_rec) ?
+                        Signal::LONG : Signal::SHORT);
+        }
+        add_signal_step(lo, hi);
+    }
+
+#ifdef RF433ANY_DBG_SIMULATE
+    byte f = word_failures(psec);
+    assert((failed & f) == f);
+#endif
+
+    for (byte id = RF433ANY_ID_START; id <= RF433ANY_ID_MANCHESTER; ++id) {
+        if (!has_failed(id))
+            return id;
+    }
+    return RF433ANY_ID_RAW_UNKNOWN_CODING;
+}
+
+    // Returns decoders that fail on psec (bit N set if decoder of id N
+    // fails, as in failed), out of a few bitwise operations on low_rec and
+    // high_rec. Only the signal steps having both a low and a high are looked
+    // at, therefore a decoder not reported may fail as well.
+byte DecoderProbe::word_failures(const Section *psec) {
+    byte n = psec->high_bits;
+    if (psec->low_bits != n && psec->low_bits != n + 1)
+        return 0;
+    byte f = 0;
+
+        // Each low with the high of the same step
+    recorded_t mask = rec_mask(n);
+    recorded_t x = ((psec->low_rec >> (psec->low_bits - n)) ^ psec->high_rec)
+                   & mask;
+    if (x)
+        f |= (1 << RF433ANY_ID_RAW_SYNC);
+    if (x != mask)
+        f |= (1 << RF433ANY_ID_TRIBIT);
+
+        // Each low with the high of the previous step
+    if (psec->low_bits == n + 1) {
+        x = (psec->low_rec ^ psec->high_rec) & mask;
+    } else if (n) {
+        mask = rec_mask(n - 1);
+        x = (psec->low_rec ^ (psec->high_rec >> 1)) & mask;
+    }
+    if (x != mask)
+        f |= (1 << RF433ANY_ID_TRIBIT_INV);
+
+    return f;
+}
+
+
+// * *********** **************************************************************
+// * DecoderHits **************************************************************
+// * *********** **************************************************************
+
+void DecoderHits::reset() {
+    for (byte id = 0; id < sizeof(hits) / sizeof(*hits); ++id)
+        hits[id] = 0;
+}
+
+void DecoderHits::hit(byte id) {
+    if (id >= sizeof(hits) / sizeof(*hits))
+        return;
+    if (hits[id] == 255) {
+        for (byte i = 0; i < sizeof(hits) / sizeof(*hits); ++i)
+            hits[i] >>= 1;
+    }
+    ++hits[id];
+}
+
+    // In case of a tie, the first one of the enumeration
+byte DecoderHits::get_favorite() const {
+    byte fav = RF433ANY_ID_TRIBIT;
+    for (byte id = RF433ANY_ID_TRIBIT_INV; id <= RF433ANY_ID_MANCHESTER;
+            ++id) {
+        if (hits[id] > hits[fav])
+            fav = id;
+    }
+    return fav;
+}
+
+
+// * ************ *************************************************************
+// * DecoderChain *************************************************************
+// * ************ *************************************************************
+
+void DecoderChain::add_section(const Section *psec, uint16_t initseq,
+        byte convention) {
+
+    if (abs(psec->low_bits - psec->high_bits) >= 2) {
+            // Defensive programming (should never happen).
+        if (!pdec) {
+            pdec = new DecoderRawInconsistent();
+        }
+
+    } else if (psec->low_bands == 1 && psec->high_bands == 1) {
+        byte n = (psec->low_bits < psec->high_bits ?
+                  psec->low_bits : psec->high_bits);
+        if (pdec) {
+            pdec->add_sync(n);
+        } else {
+            pdec = new DecoderRawSync(n);
+            pdec->take_into_account_first_low_high(psec, false);
+        }
+
+#ifdef RF433ANY_MULTI_BANDS
+    } else if (psec->low_bands > 2 || psec->high_bands > 2) {
+        bool is_continuation_of_prev_section = pdec;
+        if (!pdec)
+            pdec = new DecoderMultiWidth();
+        pdec->decode_section(psec, is_continuation_of_prev_section);
+#endif
+
+    } else if (psec->low_bands == 1 || psec->high_bands == 1) {
+        if (!pdec) {
+            pdec = new DecoderRawInconsistent();
+        }
+
+    } else {
+        bool is_continuation_of_prev_section = pdec;
+        if (pdec) {
+            pdec->decode_section(psec, true);
+        } else {
+            if (phits)
+                pdec = decode_with_favorite(psec, convention);
+            if (!pdec) {
+                DecoderProbe probe;
+                byte id = probe.probe_section(psec);
+#ifdef RF433ANY_DBG_SIMULATE
+                    // The decoders that come before id in the enumeration
+                    // must all have errors.
+                for (byte i = RF433ANY_ID_START; i < id; ++i) {
+                    Decoder *ptest = Decoder::build_decoder(i, convention);
+                    ptest->decode_section(psec, false);
+                    assert(ptest->get_nb_errors());
+                    delete ptest;
+                }
+#endif
+                pdec = Decoder::build_decoder(id, convention);
+                pdec->decode_section(psec, false);
+            }
+            if (phits)
+                phits->hit(pdec->get_id());
+        }
+
+            // The last enumerated decoder is DecoderRawUnknownCoding, that
+            // never produces any error and is chosen if no other worked.
+        assert(is_continuation_of_prev_section || !pdec->get_nb_errors());
+
+    }
+    assert(pdec);
+
+    pdec->set_ts((head ? 0 : initseq), psec->ts);
+
+    if (psec->sts != STS_CONTINUED)
+        close_pdec();
+}
+
+    // Returns the favorite decoder (see DecoderHits) having decoded psec, if
+    // it is the one DecoderProbe would choose, nullptr otherwise.
+Decoder *DecoderChain::decode_with_favorite(const Section *psec,
+        byte convention) {
+    byte id = phits->get_favorite();
+    byte before = ((1 << id) - 1) & ~((1 << RF433ANY_ID_START) - 1);
+    if ((DecoderProbe::word_failures(psec) & before) != before)
+        return nullptr;
+
+    Decoder *pfav = Decoder::build_decoder(id, convention);
+    pfav->decode_section(psec, false);
+    if (pfav->get_nb_errors()) {
+        delete pfav;
+        return nullptr;
+    }
+#ifdef RF433ANY_DBG_SIMULATE
+    DecoderProbe probe;
+    assert(probe.probe_section(psec) == id);
+#endif
+    return pfav;
+}
+
+void DecoderChain::close_pdec() {
+    if (!pdec)
+        return;
+    if (!head) {
+        assert(!tail);
+        head = pdec;
+    } else {
+        assert(tail);
+        tail->attach(pdec);
+    }
+    tail = pdec;
+    pdec = nullptr;
+}
+
+    // Returns the decoders closed so far (the caller takes ownership), the
+    // one of the current section (if continued) staying in the chain.
+Decoder* DecoderChain::take_closed() {
+    Decoder *ret = head;
+    head = nullptr;
+    tail = nullptr;
+    return ret;
+}
+
+    // Returns the decoders (the caller takes ownership), the last section
+    // being terminated whatever its status, and empties the chain.
+Decoder* DecoderChain::close() {
+    close_pdec();
+    Decoder *ret = head;
+    init(phits);
+    return ret;
+}
+
+void DecoderChain::clear() {
+    Decoder *pdec0 = close();
+    if (pdec0)
+        delete pdec0;
+}
+
+
+// * ***** ********************************************************************
+// * Track ********************************************************************
+// * ***** ********************************************************************
+
+#ifdef RF433ANY_DBG_SIMULATE
+RF433SerialLine sl;
 char buffer[RF433SERIAL_LINE_BUF_LEN];
 
 duration_t sim_timings[SIM_TIMINGS_LEN];
@@ -1170,43 +2407,185 @@ unsigned int sim_int_count_svg;
 unsigned int counter;
 #endif
 
+Track::Track(int arg_pin_number, byte mood, void (*arg_ih_func)(),
+        void (*arg_ih_wait_free_func)()):
 #ifdef RF433ANY_DBG_TIMINGS
-uint16_t Track::ih_dbg_timings[40];
-uint16_t Track::ih_dbg_exec[40];
-unsigned int Track::ih_dbg_pos = 0;
+        ih_dbg_pos(0),
+#endif
+        pin_number(arg_pin_number),
+        ih_func(arg_ih_func),
+        ih_wait_free_func(arg_ih_wait_free_func),
+        IH_last_t(0),
+        IH_level(0),
+        IH_interrupt_handler_is_attached(false),
+#ifdef RF433ANY_IH_STORM_GUARD
+        IH_storm_min_d(0),
+        IH_storm_backoff_ms(0),
+        IH_storm_last16(0),
+        IH_storm_count_short(0),
+        IH_storm(false),
+        IH_storm_start(0),
+        IH_storm_nb_episodes(0),
+        IH_storm_total_ms(0),
+#endif
+#ifdef RF433ANY_IDLE_TIMEOUT
+        idle_timeout_us(0),
+#endif
+#ifdef RF433ANY_IH_BATCH
+        IH_block_pos(0),
+        IH_block_len(0),
 #endif
-volatile IH_timing_t Track::IH_timings[IH_SIZE];
-volatile unsigned char Track::IH_write_head = 0;
-volatile unsigned char Track::IH_read_head = 0;
-byte Track::IH_max_pending_timings = 0;
-bool Track::IH_interrupt_handler_is_attached = false;
-volatile short Track::IH_wait_free_count_ok;
-volatile uint16_t Track::IH_wait_free_last16;
-
-    // Set when Track object is created
-byte Track::pin_number = 99;
-
-Track::Track(int arg_pin_number, byte mood):
         r_low(mood),
         r_high(mood),
+#if RF433ANY_RAWCODE_QUEUE > 0
+        rc_head(0),
+        rc_count(0),
+#endif
+#ifdef RF433ANY_STREAM
+        stream_func(nullptr),
+        stream_data(nullptr),
+#endif
         head(nullptr),
+        tail(nullptr),
+#ifdef RF433ANY_CALLBACK_INDEX
+        nb_callbacks(0),
+        buckets(nullptr),
+        nb_buckets(0),
+#endif
+#ifdef RF433ANY_MASKED_CALLBACKS
+        masks(nullptr),
+#endif
+#ifdef RF433ANY_CODEBOOK
+        codebook(nullptr),
+        codebook_nb_entries(0),
+        codebook_func(nullptr),
+        codebook_data(nullptr),
+#endif
         opt_wait_free_433_before_calling_callbacks(false) {
-    pin_number = arg_pin_number;
-    treset();
+#ifdef RF433ANY_ADAPTIVE_ORDER
+    decoder_hits.reset();
+#endif
+#ifdef RF433ANY_RECENT_CODES
+    recent_window = RF433ANY_RECENT_WINDOW_MS;
+    reset_recent_codes();
+#endif
+#ifdef RF433ANY_INCREMENTAL_DECODING
+    rawcode.chain.init(get_phits());
+#endif
+#ifdef RF433ANY_STREAM
+    stream_chain.init(get_phits());
+#endif
+    trk_reset();
+}
+
+Track::Track(int arg_pin_number, byte mood):
+        Track(arg_pin_number, mood, &TrackISR<0>::ih_handle_interrupt,
+                &TrackISR<0>::ih_handle_interrupt_wait_free) {
+    bind_slot(&TrackISR<0>::ptrack);
+}
+
+    // Binds the trampolines of a slot (*pslot being their ptrack) to this Track
+    // object. A slot can be bound once only: otherwise, the Track object bound
+    // first would no longer receive its interrupts.
+void Track::bind_slot(Track **pslot) {
+    assert(!*pslot);
+    *pslot = this;
 }
 
+    // Without queue of codes (RF433ANY_RAWCODE_QUEUE set to 0), resets Track.
+    // With a queue, discards the oldest code received (the one get_data()
+    // works on), reception going on. If no code is queued, resets Track.
 void Track::treset() {
+#if RF433ANY_RAWCODE_QUEUE > 0
+    if (rc_count) {
+#ifdef RF433ANY_RECENT_CODES
+        recent_new_reception();
+#endif
+#ifdef RF433ANY_INCREMENTAL_DECODING
+        rc_queue[rc_head].chain.clear();
+#endif
+        rc_head = (rc_head + 1) % RF433ANY_RAWCODE_QUEUE;
+        --rc_count;
+            // The queue was full, a code was waiting in rawcode
+        if (trk == TRK_DATA)
+            rawcode_enqueue();
+        return;
+    }
+#endif
+    trk_reset();
+}
+
+#if RF433ANY_RAWCODE_QUEUE > 0
+    // Called when a code is complete (trk is TRK_DATA). Moves it to the queue
+    // and resets the receiving state machine, so that reception goes on.
+    // Returns false if the queue is full, in which case Track stays in the
+    // TRK_DATA state: recording stops until treset() gets called, as without
+    // a queue.
+bool Track::rawcode_enqueue() {
+    if (rc_count == RF433ANY_RAWCODE_QUEUE)
+        return false;
+    rc_queue[(rc_head + rc_count) % RF433ANY_RAWCODE_QUEUE] = rawcode;
+    ++rc_count;
+#ifdef RF433ANY_INCREMENTAL_DECODING
+        // The decoders now belong to the queued code
+    rawcode.chain.init(get_phits());
+#endif
+    trk_reset();
+    return true;
+}
+#endif
+
+    // Ends the code being received, keeping the sections recorded so far.
+void Track::trk_terminate() {
+    if (trk != TRK_RECV)
+        return;
+#ifdef RF433ANY_STREAM
+    if (stream_func) {
+        stream_flush();
+        trk_reset();
+        return;
+    }
+#endif
+    if (rawcode.nb_sections) {
+        trk = TRK_DATA;
+#if RF433ANY_RAWCODE_QUEUE > 0
+        rawcode_enqueue();
+#endif
+    } else {
+        trk_reset();
+    }
+}
+
+    // Resets the receiving state machine.
+void Track::trk_reset() {
+#ifdef RF433ANY_RECENT_CODES
+        // Unless get_data() works on a queued code
+#if RF433ANY_RAWCODE_QUEUE > 0
+    if (!rc_count)
+#endif
+        recent_new_reception();
+#endif
     trk = TRK_WAIT;
     rawcode.nb_sections = 0;
+#ifdef RF433ANY_INCREMENTAL_DECODING
+    rawcode.chain.clear();
+#endif
+#ifdef RF433ANY_STREAM
+        // A frame left pending (the code being interrupted) is discarded
+    stream_chain.clear();
+#endif
+#ifdef RF433ANY_IH_SQUELCH
+    ih_squelch_close_gate();
+#endif
 }
 
-#if defined(ESP8266)
-IRAM_ATTR
-#endif
-void Track::ih_handle_interrupt() {
-    static unsigned long last_t = 0;
+RF433ANY_IRAM_ATTR void Track::ih_handle_interrupt() {
     const unsigned long t = micros();
 
+        // No ideal solution when the ring is full: either we write nothing,
+        // or, we loose the oldest entry that was the next one to read, or, we
+        // give up the frame being received.
+        // See RF433ANY_IH_OVERFLOW_POLICY.
 #ifdef RF433ANY_DBG_SIMULATE
     unsigned long d;
     byte r = sim_int_count % 2;
@@ -1216,41 +2595,301 @@ void Track::ih_handle_interrupt() {
     } else {
         d = uncompact(sim_timings[sim_int_count++]);
     }
-    (void)last_t;
     (void)t;
+    if (d > RF433ANY_MAX_DURATION)
+        d = RF433ANY_MAX_DURATION;
+    ih_queue_timing(r, d);
 #else
-    unsigned long d = t - last_t;
-    last_t = t;
-    byte r = (digitalRead(pin_number) == HIGH ? 1 : 0);
+    ih_record_edge(digitalRead(pin_number) == HIGH ? 1 : 0, t);
 #endif
+}
 
-    if (d > RF433ANY_MAX_DURATION)
-        d = RF433ANY_MAX_DURATION;
+    // Record a timing as if it had been measured by the interrupt handler.
+    // Allows to feed Track from elsewhere (a simulation, another interrupt
+    // handler, ...)
+    // NOTE
+    //   Not to be called while the interrupt handler is attached, as it'd
+    //   break the 'single producer' requirement of IH_timings.
+void Track::ih_push_timing(byte r, uint16_t d) {
+    ih_queue_timing(r, d);
+}
 
-    unsigned char next_IH_write_head = (IH_write_head + 1) & IH_MASK;
-        // No ideal solution here: we reached the buffer size, so either we
-        // write nothing, or, we loose the oldest entry that was the next one to
-        // read.
-        // Solution here: we loose oldest entry in buffer and do the write.
-    if (next_IH_write_head == IH_read_head) {
-        IH_read_head = (IH_read_head + 1) & IH_MASK;
+byte Track::ih_get_max_pending_timings() {
+    IH_stats_t stats;
+    ih_get_stats(&stats);
+    return stats.max_pending;
+}
+
+void Track::ih_get_stats(IH_stats_t *pstats) {
+    noInterrupts();
+    IH_timings.get_stats(pstats);
+    interrupts();
+}
+
+void Track::ih_reset_stats() {
+    noInterrupts();
+    IH_timings.reset_stats();
+#ifdef RF433ANY_IH_SQUELCH
+    IH_squelch.reset_stats();
+#endif
+#ifdef RF433ANY_IH_STORM_GUARD
+    IH_storm_nb_episodes = 0;
+    IH_storm_total_ms = 0;
+#endif
+    interrupts();
+}
+
+#ifdef RF433ANY_IH_STORM_GUARD
+    // Storm guard: if the edge rate stays above max_edges_per_second, the
+    // interrupt handler is detached, and attached again by do_events() once
+    // backoff_ms milliseconds have elapsed.
+    // max_edges_per_second set to 0 disables the guard (default).
+    // NOTE
+    //   The rate is assessed on the duration of each timing, not on an actual
+    //   count of edges during one second, see RF433ANY_IH_STORM_MIN_SHORT.
+void Track::setopt_ih_storm_guard(uint32_t max_edges_per_second,
+        uint16_t backoff_ms) {
+    uint32_t min_d = 0;
+    if (max_edges_per_second) {
+        min_d = 1000000 / max_edges_per_second;
+        if (min_d > 0xffff)
+            min_d = 0xffff;
+        else if (!min_d)
+            min_d = 1;
     }
-    IH_write_head = next_IH_write_head;
-    IH_timings[IH_write_head].r = r;
-    IH_timings[IH_write_head].d = d;
+    noInterrupts();
+    IH_storm_min_d = min_d;
+    IH_storm_backoff_ms = backoff_ms;
+    IH_storm_last16 = 0;
+    IH_storm_count_short = 0;
+    interrupts();
+}
+
+void Track::ih_get_storm_stats(IH_storm_stats_t *pstats) {
+    noInterrupts();
+    pstats->nb_episodes = IH_storm_nb_episodes;
+    pstats->total_ms = IH_storm_total_ms;
+    pstats->in_storm = IH_storm;
+    interrupts();
+}
+
+    // Called by the interrupt handler for each timing.
+    // Returns true if the timing is to be discarded, because of a storm.
+    // NOTE
+    //   The handler is not detached here (detachInterrupt() is not safe in an
+    //   interrupt handler on all platforms): timings get discarded until
+    //   do_events() detaches it, see activate_recording().
+RF433ANY_IRAM_ATTR bool Track::ih_storm_detect(uint16_t d) {
+    if (IH_storm)
+        return true;
+
+        // Same approach as in ih_handle_interrupt_wait_free()
+    byte new_bit = (d < IH_storm_min_d);
+    byte old_bit = !!(IH_storm_last16 & 0x8000);
+    IH_storm_last16 <<= 1;
+    IH_storm_last16 |= new_bit;
+
+    IH_storm_count_short += new_bit;
+    IH_storm_count_short -= old_bit;
+
+    if (IH_storm_count_short < RF433ANY_IH_STORM_MIN_SHORT)
+        return false;
+
+    IH_storm = true;
+    IH_storm_start = millis();
+    if (IH_storm_nb_episodes != 0xffff)
+        ++IH_storm_nb_episodes;
+    return true;
+}
+
+    // To be called by the main loop during a storm, once the interrupt handler
+    // got detached (no need for a critical section).
+    // Returns true if the backoff delay has elapsed, in which case the storm
+    // guard is ready to record again. The code being received when the storm
+    // started, if any, is given up.
+bool Track::ih_storm_is_over() {
+    unsigned long elapsed = millis() - IH_storm_start;
+    if (elapsed < IH_storm_backoff_ms)
+        return false;
+
+    IH_storm_total_ms += elapsed;
+    IH_storm_last16 = 0;
+    IH_storm_count_short = 0;
+    IH_storm = false;
+    if (trk != TRK_DATA)
+        trk_reset();
+    return true;
+}
+#endif
+
+#ifdef RF433ANY_IH_SQUELCH
+    // min_d is the duration below which a timing is a glitch, 0 to disable the
+    // squelch.
+void Track::setopt_ih_squelch(uint16_t min_d) {
+    noInterrupts();
+    IH_squelch.set_min_d(min_d);
+    interrupts();
+}
+
+void Track::ih_get_squelch_stats(IH_squelch_stats_t *pstats) {
+    noInterrupts();
+    IH_squelch.get_stats(pstats);
+    interrupts();
+}
+
+    // The gate is closed only if no timing is waiting to be eaten, as one of
+    // them could be the start of a code.
+    // NOTE
+    //   trk_reset() is called by the constructor, when interrupts must not be
+    //   enabled yet, hence the critical section only when the interrupt
+    //   handler is attached.
+void Track::ih_squelch_close_gate() {
+    if (!ih_block_is_empty())
+        return;
+    bool attached = IH_interrupt_handler_is_attached;
+    if (attached)
+        noInterrupts();
+    if (!IH_timings.get_pending())
+        IH_squelch.close_gate();
+    if (attached)
+        interrupts();
+}
+#endif
+
+void Track::setopt_ih_overflow_policy(byte policy) {
+    noInterrupts();
+    IH_timings.set_policy(policy);
+    interrupts();
 }
 
 void Track::force_stop_recv() {
 #ifdef RF433ANY_DBG_TRACE
     dbg("T> running force_stop_recv()");
 #endif
-    if (get_trk() == TRK_RECV) {
-        track_eat(0, 0);
-        track_eat(1, 0);
+    if (trk == TRK_RECV) {
+            // The first two timings of a section are not checked (see
+            // track_eat_recv()): if a section was just started, it takes two
+            // more for the reception to end.
+        for (byte i = 0; i < 2 && trk == TRK_RECV; ++i) {
+            track_eat(0, 0);
+            track_eat(1, 0);
+        }
         do_events();
     }
 }
 
+#ifdef RF433ANY_IDLE_TIMEOUT
+    // If no edge is received during timeout_ms milliseconds while a code is
+    // being received, the code is terminated (see check_idle()).
+    // timeout_ms set to 0 disables the timeout (default).
+    // Compiled in if RF433ANY_IDLE_TIMEOUT is defined.
+    // IMPORTANT
+    //   timeout_ms must be greater than the longest separator between two
+    //   repeats of the codes to receive (up to 65 ms), otherwise codes get cut
+    //   at their first separator.
+void Track::setopt_idle_timeout(uint16_t timeout_ms) {
+    idle_timeout_us = (unsigned long)timeout_ms * 1000;
+}
+
+    // Terminates the code being received if the last edge is older than the
+    // idle timeout, t being the current time (as returned by micros()).
+    // Called by do_events() while the interrupt handler is attached. Can be
+    // called directly when timings are recorded with ih_record_edge().
+    // Returns true if the timeout expired (then, the code being received is
+    // terminated).
+    // NOTE
+    //   The timing of the last edge is still held back by the ring (and by
+    //   the squelch, if any), as it is delivered only once the next edge
+    //   comes. It is taken from there, then the silence that follows is eaten
+    //   as one last timing, so that the current section is terminated the
+    //   same way as if the next edge had come.
+bool Track::check_idle(unsigned long t) {
+    if (!idle_timeout_us || trk != TRK_RECV || !ih_block_is_empty())
+        return false;
+
+    IH_timing_t held[2];
+    byte nb_held = 0;
+
+    noInterrupts();
+    unsigned long d = t - IH_last_t;
+    if (d < idle_timeout_us || IH_timings.get_pending()) {
+        interrupts();
+        return false;
+    }
+    IH_timings.take_last(&held[nb_held++]);
+#ifdef RF433ANY_IH_SQUELCH
+    if (IH_squelch.take_held(&held[nb_held]))
+        ++nb_held;
+#endif
+    interrupts();
+
+#ifdef RF433ANY_DBG_TRACE
+    dbgf("T> idle for %lu us, terminating code", d);
+#endif
+    for (byte i = 0; i < nb_held; ++i)
+        eat_timing(held[i]);
+    if (trk == TRK_RECV) {
+        track_eat(!held[nb_held - 1].r,
+                (d >> 16) ? RF433ANY_MAX_DURATION : (uint16_t)d);
+    }
+    trk_terminate();
+    return true;
+}
+#endif
+
+#ifdef RF433ANY_STREAM
+    // Streaming mode: when func is not null, each section is decoded as soon
+    // as it is recorded, and each frame, once complete, is passed to func
+    // (along with data), then deleted. Sections are not stored, so that
+    // there is no limit on the number of sections (RF433ANY_MAX_SECTIONS)
+    // and memory use does not depend on the length of the transmission.
+    // Once the transmission is over, the last frame gets passed to func and
+    // Track goes back to waiting for a code: it never gets to the TRK_DATA
+    // state, and get_data() has nothing to return.
+    // func is called by do_events() (not by the interrupt handler). pdec is
+    // decoded with the convention RF433ANY_CONV0 and must not be kept after
+    // func returns.
+    // func set to null disables streaming (default).
+    // Compiled in if RF433ANY_STREAM is defined.
+    // IMPORTANT
+    //   Call it when Track is not receiving (before activate_recording() or
+    //   after treset()).
+void Track::setopt_stream(void (*func)(const Decoder *pdec, void *data),
+        void *data) {
+    stream_func = func;
+    stream_data = data;
+}
+
+void Track::stream_section(const Section *psec) {
+        // rawcode.nb_sections is 1 for the first section of a code, 2 for
+        // the next ones (the previous section being kept, see below).
+    stream_chain.add_section(psec,
+            (rawcode.nb_sections == 1 ? rawcode.initseq : 0),
+            RF433ANY_CONV0);
+    stream_deliver(stream_chain.take_closed());
+
+        // Only the last section is kept, as the state machine looks at its
+        // status when the next one ends.
+    if (rawcode.nb_sections > 1) {
+        rawcode.sections[0] = *psec;
+        rawcode.nb_sections = 1;
+    }
+}
+
+void Track::stream_deliver(Decoder *pdec) {
+    if (!pdec)
+        return;
+    stream_func(pdec, stream_data);
+    delete pdec;
+}
+
+    // Delivers the frame left pending, if any (the last section of the
+    // transmission having the status STS_CONTINUED).
+void Track::stream_flush() {
+    stream_deliver(stream_chain.close());
+}
+#endif
+
 void Track::reset_border_mgmt() {
     count = 0;
     first_low = 0;
@@ -1258,27 +2897,53 @@ void Track::reset_border_mgmt() {
     last_low = 0;
 }
 
-inline void Track::track_eat(byte r, uint16_t d) {
+    // A timing is eaten in two steps at most: when the code being received
+    // gets reset (or queued, see RF433ANY_RAWCODE_QUEUE), the timing that
+    // caused it is eaten again in the TRK_WAIT state, as it can be the
+    // initialization sequence of the next code. In the TRK_WAIT state, a
+    // timing is always eaten in one step.
+void Track::track_eat(byte r, uint16_t d) {
+    for (byte step = 0; step < 2; ++step) {
 
 #ifdef RF433ANY_DBG_TRACE
-    dbgf("T> trk = %d, r = %d, d = %u", trk, r, d);
-#endif
-
-    if (trk == TRK_WAIT) {
-        if (r == 1 && d >= TRACK_MIN_INITSEQ_DURATION) {
-            r_low.rreset();
-            r_high.rreset();
-            prev_r = r;
-            rawcode.initseq = d;
-            rawcode.max_code_d = d - (d >> 2);
-            reset_border_mgmt();
-            trk = TRK_RECV;
+        dbgf("T> trk = %d, r = %d, d = %u", trk, r, d);
+#endif
+
+        switch (trk) {
+            case TRK_WAIT:
+                track_eat_wait(r, d);
+                return;
+            case TRK_RECV:
+                if (track_eat_recv(r, d))
+                    return;
+                break;
+            default:
+                return;
         }
-        return;
-    } else if (trk != TRK_RECV) {
-        return;
     }
+        // Never executed: after a reset, trk is TRK_WAIT.
+    assert(false);
+}
+
+void Track::track_eat_wait(byte r, uint16_t d) {
+    if (r == 1 && d >= TRACK_MIN_INITSEQ_DURATION) {
+        r_low.rreset();
+        r_high.rreset();
+        prev_r = r;
+        rawcode.initseq = d;
+        rawcode.max_code_d = d - (d >> 2);
+        reset_border_mgmt();
+        trk = TRK_RECV;
+    }
+}
 
+    // Returns true if the timing got eaten, false if it is to be eaten again
+    // (the code being received got reset, or queued).
+    // NOTE
+    //   r is set to 1 when the timing is not taken into account (see
+    //   enforce_b_to_false), and the timing is then eaten again with this
+    //   value.
+bool Track::track_eat_recv(byte& r, uint16_t d) {
     bool enforce_b_to_false = false;
         // [COMMENT002]
         // We missed an interrupt apparently (two calls with same r), so we
@@ -1299,34 +2964,28 @@ inline void Track::track_eat(byte r, uint16_t d) {
 #ifdef RF433ANY_DBG_TRACE
             dbg("T> case 1");
 #endif
-            treset();
-                // WARNING
-                //   Re-entrant call... not ideal.
-            track_eat(r, d);
-        } else {
+            trk_reset();
+            return false;
+        }
 #ifdef RF433ANY_DBG_TRACE
-            dbg("T> case 2");
+        dbg("T> case 2");
 #endif
-            first_low = d;
-        }
-        return;
+        first_low = d;
+        return true;
     } else if (count == 2) {
         if ((d < BAND_MIN_D || d >= rawcode.max_code_d)
             && count < TRACK_MIN_BITS && !rawcode.nb_sections) {
 #ifdef RF433ANY_DBG_TRACE
             dbg("T> case 3");
 #endif
-            treset();
-                // WARNING
-                //   Re-entrant call... not ideal.
-            track_eat(r, d);
-        } else {
+            trk_reset();
+            return false;
+        }
 #ifdef RF433ANY_DBG_TRACE
-            dbg("T> case 4");
+        dbg("T> case 4");
 #endif
-            first_high = d;
-        }
-        return;
+        first_high = d;
+        return true;
     }
 #ifdef RF433ANY_DBG_TRACE
     dbg("T> case 5");
@@ -1334,7 +2993,7 @@ inline void Track::track_eat(byte r, uint16_t d) {
 
     Rail *prail = (r == 0 ? &r_low : &r_high);
     if (prail->status != RAIL_OPEN)
-        return;
+        return true;
 
     if (r == 0)
         last_low = d;
@@ -1481,10 +3140,18 @@ Notations:
             psec->ts.sep = (sts == STS_SHORT_SEP
                            || sts == STS_LONG_SEP
                            || sts == STS_SEP_SEP ? d : 0);
-            if (r_low.b_short.test_value(r_high.b_short.mid)
-                    && !r_low.b_short.test_value(r_high.b_long.mid)
-                    && !r_low.b_long.test_value(r_high.b_short.mid)
-                    && r_low.b_long.test_value(r_high.b_long.mid)) {
+#ifdef RF433ANY_MULTI_BANDS
+            Band low_short;
+            Band low_long;
+            r_low.get_default_bands(&low_short, &low_long);
+#else
+            Band& low_short = r_low.b_short;
+            Band& low_long = r_low.b_long;
+#endif
+            if (low_short.test_value(r_high.b_short.mid)
+                    && !low_short.test_value(r_high.b_long.mid)
+                    && !low_long.test_value(r_high.b_short.mid)
+                    && low_long.test_value(r_high.b_long.mid)) {
                 psec->ts.low_short = (r_low.b_short.mid + r_high.b_short.mid)
                                     >> 1;
                 psec->ts.low_long = (r_low.b_long.mid + r_high.b_long.mid)
@@ -1504,13 +3171,28 @@ Notations:
             psec->high_rec = r_high.rec;
             psec->high_bits = r_high.index;
             psec->high_bands = r_high.get_band_count();
+#ifdef RF433ANY_MULTI_BANDS
+            r_low.get_symbols(&psec->low_rec, &psec->low_rec2);
+            r_high.get_symbols(&psec->high_rec, &psec->high_rec2);
+#endif
 
             psec->first_low = first_low;
             psec->first_high = first_high;
             psec->last_low = last_low;
-
-            trk = ((rawcode.nb_sections == RF433ANY_MAX_SECTIONS)
-                    ? TRK_DATA : TRK_RECV);
+#ifdef RF433ANY_STREAM
+            if (stream_func) {
+                stream_section(psec);
+                trk = TRK_RECV;
+            } else
+#endif
+            {
+#ifdef RF433ANY_INCREMENTAL_DECODING
+                rawcode.chain.add_section(psec, rawcode.initseq,
+                        RF433ANY_CONV0);
+#endif
+                trk = (rawcode.nb_sections == RF433ANY_MAX_SECTIONS
+                        ? TRK_DATA : TRK_RECV);
+            }
 
 #ifdef RF433ANY_DBG_TRACE
             dbgf("T> rawcode.nb_sections = %d", rawcode.nb_sections);
@@ -1528,23 +3210,60 @@ Notations:
             } else {
 #ifdef RF433ANY_DBG_TRACE
                 dbg("T> stop receiving (data)");
+#endif
+#if RF433ANY_RAWCODE_QUEUE > 0
+                if (rawcode_enqueue())
+                    return false;
 #endif
             }
         } else {
+#ifdef RF433ANY_STREAM
+            if (stream_func) {
+#ifdef RF433ANY_DBG_TRACE
+                dbg("T> end of stream");
+#endif
+                stream_flush();
+                trk_reset();
+                return false;
+            }
+#endif
             if (rawcode.nb_sections) {
                 trk = TRK_DATA;
+#if RF433ANY_RAWCODE_QUEUE > 0
+                if (rawcode_enqueue())
+                    return false;
+#endif
             } else {
-                treset();
-                    // WARNING
-                    //   Re-entrant call... not ideal.
-                track_eat(r, d);
+                trk_reset();
+                return false;
             }
         }
 
     }
+    return true;
+}
+
+void Track::eat_timing(const IH_timing_t& timing) {
+#ifdef RF433ANY_DBG_TIMINGS
+    unsigned long t0 = micros();
+#endif
+    track_eat(timing.r, timing.d);
+#ifdef RF433ANY_DBG_TIMINGS
+    unsigned long d = micros() - t0;
+    if (d > RF433ANY_MAX_DURATION)
+        d = RF433ANY_MAX_DURATION;
+    ih_dbg_exec[ih_dbg_pos] = d;
+    if (trk == TRK_WAIT)
+        ih_dbg_pos = 0;
+    else {
+        if (ih_dbg_pos < sizeof(ih_dbg_timings) / sizeof(*ih_dbg_timings))
+            ih_dbg_timings[ih_dbg_pos++] = timing.d;
+    }
+#endif
 }
 
-    // Returns true if a timing got processed, false otherwise.
+    // Returns true if a timing got processed (or if the frame got aborted
+    // following a ring overflow), false otherwise.
     // Do nothing (and returns false) if Track is in the status TRK_DATA.
     // NOTE
     //   When Track is in the TRK_DATA state, no erase can happen
@@ -1552,39 +3271,35 @@ Notations:
     //   Therefore the safeguard of explicitly doing nothing if in the status
     //   TRK_DATA is redundant => it is defensive programming.
 bool Track::process_interrupt_timing() {
-    if (get_trk() == TRK_DATA)
+    if (trk == TRK_DATA)
         return false;
 
-    unsigned char IH_pending_timings =
-        (IH_write_head - IH_read_head) & IH_MASK;
-    if (IH_pending_timings > IH_max_pending_timings)
-        IH_max_pending_timings = IH_pending_timings;
+#ifdef RF433ANY_IH_BATCH
+        // Timings left over by process_interrupt_timings() come first.
+    if (IH_block_pos < IH_block_len) {
+        eat_timing(IH_block[IH_block_pos++]);
+        return true;
+    }
+#endif
 
     bool ret;
 
     noInterrupts();
-    if (IH_read_head != IH_write_head) {
-        IH_timing_t timing = IH_timings[IH_read_head];
-        IH_read_head = (IH_read_head + 1) & IH_MASK;
-
+    if (IH_timings.take_overflow()) {
+            // RF433ANY_IH_ABORT_FRAME policy: timings got lost, what is being
+            // received can no longer be trusted.
         interrupts();
-#ifdef RF433ANY_DBG_TIMINGS
-        unsigned long t0 = micros();
-#endif
-        track_eat(timing.r, timing.d);
-#ifdef RF433ANY_DBG_TIMINGS
-        unsigned long d = micros() - t0;
-        if (d > RF433ANY_MAX_DURATION)
-            d = RF433ANY_MAX_DURATION;
-        ih_dbg_exec[ih_dbg_pos] = d;
-        if (get_trk() == TRK_WAIT)
-            ih_dbg_pos = 0;
-        else {
-            if (ih_dbg_pos < sizeof(ih_dbg_timings) / sizeof(*ih_dbg_timings))
-                ih_dbg_timings[ih_dbg_pos++] = timing.d;
-        }
+#ifdef RF433ANY_DBG_TRACE
+        dbg("T> timings ring overflow, frame aborted");
 #endif
+        trk_reset();
+        return true;
+    }
 
+    IH_timing_t timing;
+    if (IH_timings.pop(&timing)) {
+        interrupts();
+        eat_timing(timing);
         ret = true;
 
     } else {
@@ -1596,11 +3311,66 @@ bool Track::process_interrupt_timing() {
     return ret;
 }
 
+    // Same as process_interrupt_timing(), except that all pending timings are
+    // copied out of the ring at once, in one critical section, then eaten
+    // with interrupts enabled.
+    // If Track enters the TRK_DATA status in the middle, the remaining timings
+    // are kept for later (same as what happens with process_interrupt_timing()
+    // where they'd remain in the ring.)
+    // Without RF433ANY_IH_BATCH, same as calling process_interrupt_timing()
+    // until it returns false.
+bool Track::process_interrupt_timings() {
+#ifndef RF433ANY_IH_BATCH
+    bool ret = false;
+    while (process_interrupt_timing())
+        ret = true;
+    return ret;
+#else
+    if (trk == TRK_DATA)
+        return false;
+
+    if (IH_block_pos == IH_block_len) {
+        noInterrupts();
+        bool overflowed = IH_timings.take_overflow();
+        IH_block_len = IH_timings.pop_all(IH_block,
+                sizeof(IH_block) / sizeof(*IH_block));
+        interrupts();
+        IH_block_pos = 0;
+
+        if (overflowed) {
+                // See process_interrupt_timing()
+#ifdef RF433ANY_DBG_TRACE
+            dbg("T> timings ring overflow, frame aborted");
+#endif
+            trk_reset();
+            return true;
+        }
+    }
+
+    if (IH_block_pos == IH_block_len)
+        return false;
+
+    while (IH_block_pos < IH_block_len && trk != TRK_DATA)
+        eat_timing(IH_block[IH_block_pos++]);
+
+    return true;
+#endif
+}
+
 void Track::activate_recording() {
+#ifdef RF433ANY_IH_STORM_GUARD
+    if (IH_storm) {
+            // The interrupt handler detected a storm and discards timings
+            // since then, it is detached during the backoff delay.
+        deactivate_recording();
+        if (!ih_storm_is_over())
+            return;
+    }
+#endif
 #ifndef RF433ANY_DBG_SIMULATE
     if (!IH_interrupt_handler_is_attached) {
-        attachInterrupt(digitalPinToInterrupt(pin_number), &ih_handle_interrupt,
-                CHANGE);
+        IH_level = (digitalRead(pin_number) == HIGH ? 1 : 0);
+        attachInterrupt(digitalPinToInterrupt(pin_number), ih_func, CHANGE);
         IH_interrupt_handler_is_attached = true;
     }
 #endif
@@ -1617,13 +3387,20 @@ void Track::deactivate_recording() {
 
 bool Track::do_events() {
     activate_recording();
-    while (process_interrupt_timing())
+    while (process_interrupt_timings())
         ;
+#ifdef RF433ANY_IDLE_TIMEOUT
+    if (idle_timeout_us && IH_interrupt_handler_is_attached)
+        check_idle(micros());
+#endif
     if (get_trk() == TRK_DATA) {
-        deactivate_recording();
+            // With a queue of codes, recording goes on, unless the queue is
+            // full.
+        if (trk == TRK_DATA)
+            deactivate_recording();
 #ifdef RF433ANY_DBG_RAWCODE
         dbgf("IH_max_pending_timings = %d", ih_get_max_pending_timings());
-        rawcode.debug_rawcode();
+        get_prawcode()->debug_rawcode();
 #endif
         check_registered_callbacks();
         return true;
@@ -1631,15 +3408,10 @@ bool Track::do_events() {
     return false;
 }
 
-#if defined(ESP8266)
-IRAM_ATTR
-#endif
-void Track::ih_handle_interrupt_wait_free() {
-    static unsigned long last_t = 0;
-
+RF433ANY_IRAM_ATTR void Track::ih_handle_interrupt_wait_free() {
     const unsigned long t = micros();
-    unsigned long d = t - last_t;
-    last_t = t;
+    unsigned long d = t - IH_last_t;
+    IH_last_t = t;
 
     if (d > RF433ANY_MAX_DURATION)
         d = RF433ANY_MAX_DURATION;
@@ -1660,8 +3432,8 @@ void Track::wait_free_433() {
     IH_wait_free_last16 = (uint16_t)0xffff;
     IH_wait_free_count_ok = 16;
 
-    attachInterrupt(digitalPinToInterrupt(pin_number),
-            &ih_handle_interrupt_wait_free, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(pin_number), ih_wait_free_func,
+            CHANGE);
 
         // 75% of the last 16 durations must be in the interval [200, 25000]
         // (that is, 12 out of 16).
@@ -1672,79 +3444,161 @@ void Track::wait_free_433() {
 }
 
 Decoder* Track::get_data_core(byte convention) {
-    Decoder *pdec_head = nullptr;
-    Decoder *pdec_tail = nullptr;
-    Decoder *pdec = nullptr;
-
-    for (byte i = 0; i < rawcode.nb_sections; ++i) {
-
-        const Section *psec = &rawcode.sections[i];
-
-        if (abs(psec->low_bits - psec->high_bits) >= 2) {
-                // Defensive programming (should never happen).
-            if (!pdec) {
-                pdec = new DecoderRawInconsistent();
-            }
+    RawCode *prawcode = get_prawcode();
+
+#ifdef RF433ANY_INCREMENTAL_DECODING
+        // The sections got decoded as they were received, unless the
+        // decoders were taken already by a previous call.
+    if (convention == RF433ANY_CONV0 && get_trk() == TRK_DATA
+            && !prawcode->chain.is_empty()) {
+        return prawcode->chain.close();
+    }
+#endif
 
-        } else if (psec->low_bands == 1 && psec->high_bands == 1) {
-            byte n = (psec->low_bits < psec->high_bits ?
-                      psec->low_bits : psec->high_bits);
-            if (pdec) {
-                pdec->add_sync(n);
-            } else {
-                pdec = new DecoderRawSync(n);
-                pdec->take_into_account_first_low_high(psec, false);
-            }
+    DecoderChain chain;
+    chain.init(get_phits());
+    for (byte i = 0; i < prawcode->nb_sections; ++i) {
+        chain.add_section(&prawcode->sections[i], prawcode->initseq,
+                convention);
+    }
+    return chain.close();
+}
 
-        } else if (psec->low_bands == 1 || psec->high_bands == 1) {
-            if (!pdec) {
-                pdec = new DecoderRawInconsistent();
+    // Merges the copies of a code that follow each other into one decoder, the
+    // data of which is the bitwise majority of the copies (see
+    // Decoder::vote()). Copies have the same encoding and the same number of
+    // bits, and differ from the first one by 1 / RF433ANY_VOTE_MAX_DIFF of
+    // their bits at most.
+void Track::majority_vote(Decoder *pdec0) {
+    for (Decoder *pdec = pdec0; pdec; pdec = pdec->get_next()) {
+        const BitVector *pdata = pdec->get_pdata();
+        if (!pdec->data_got_decoded() || !pdata || !pdata->get_nb_bits())
+            continue;
+
+        byte nb = 1;
+        Decoder *plast = pdec;
+        for (Decoder *p = pdec->get_next(); p && nb < 255;
+                p = p->get_next()) {
+            const BitVector *pd = p->get_pdata();
+            if (p->get_id() != pdec->get_id() || !p->data_got_decoded() || !pd
+                    || pd->get_nb_bits() != pdata->get_nb_bits()
+                    || pdata->distance(pd) * RF433ANY_VOTE_MAX_DIFF
+                       > pdata->get_nb_bits()) {
+                break;
             }
+            ++nb;
+            plast = p;
+        }
+        if (nb == 1)
+            continue;
+
+        pdec->vote(nb);
+        Decoder *pcopies = pdec->get_next();
+        Decoder *prest = plast->get_next();
+        plast->detach();
+        pdec->detach();
+        pdec->attach(prest);
+        delete pcopies;
+    }
+}
 
-        } else {
-            byte enum_decoders = RF433ANY_ID_START;
-            bool is_continuation_of_prev_section = pdec;
-            do {
-                if (!pdec)
-                    pdec = Decoder::build_decoder(enum_decoders, convention);
-
-                pdec->decode_section(psec, is_continuation_of_prev_section);
-
-                if (!is_continuation_of_prev_section && pdec->get_nb_errors()) {
-                    delete pdec;
-                    pdec = nullptr;
-                }
-            } while (!pdec && ++enum_decoders <= RF433ANY_ID_END);
+#ifdef RF433ANY_RECENT_CODES
+void Track::reset_recent_codes() {
+    for (byte i = 0; i < RF433ANY_RECENT_CODES; ++i) {
+        recent_codes[i].encoding = RF433ANY_ID_RAW_INCONSISTENT;
+        recent_codes[i].in_reception = false;
+    }
+    recent_recorded = false;
+}
 
-        }
-            // The last enumerated decoder is DecoderRawUnknownCoding, that
-            // never produces any error and MUST be chosen in the end (if no
-            // other worked).
-        assert(pdec);
+    // Returns the index of the entry of the code, RF433ANY_RECENT_CODES if it
+    // is not there.
+byte Track::find_recent(uint32_t hash, byte id) const {
+    for (byte i = 0; i < RF433ANY_RECENT_CODES; ++i) {
+        if (recent_codes[i].encoding == id && recent_codes[i].hash == hash)
+            return i;
+    }
+    return RF433ANY_RECENT_CODES;
+}
 
-        pdec->set_ts((pdec_head ? 0 : rawcode.initseq), psec->ts);
+    // Returns true if the code of pdec was seen less than recent_window ms
+    // before t. If it got recorded in the reception get_data() works on, it is
+    // the time it was seen before that counts.
+    // Does not update anything, see record_recent().
+bool Track::is_recent(const Decoder *pdec, uint32_t t) const {
+    byte i = find_recent(pdec->get_pdata()->get_hash(), pdec->get_id());
+    if (i == RF433ANY_RECENT_CODES)
+        return false;
+    const recent_code_t *pr = &recent_codes[i];
+    if (pr->in_reception)
+        return pr->was_recent;
+    return t - pr->last_seen < recent_window;
+}
 
-        if (psec->sts != STS_CONTINUED || i == rawcode.nb_sections - 1) {
-            if (!pdec_head) {
-                assert(!pdec_tail);
-                pdec_head = pdec;
-                pdec_tail = pdec;
-            } else {
-                assert(pdec_tail);
-                pdec_tail->attach(pdec);
-                pdec_tail = pdec;
+    // Records the code of pdec as seen at t.
+    // NOTE
+    //   Called for each code of a reception, once (see get_data()).
+void Track::record_recent(const Decoder *pdec, uint32_t t) {
+    uint32_t hash = pdec->get_pdata()->get_hash();
+    byte id = pdec->get_id();
+
+    byte i = find_recent(hash, id);
+    recent_code_t *pr;
+    if (i < RF433ANY_RECENT_CODES) {
+        pr = &recent_codes[i];
+            // The copies of a code within a reception keep the status of the
+            // first one.
+        if (!pr->in_reception)
+            pr->was_recent = (t - pr->last_seen < recent_window);
+    } else {
+            // The entry to take: one not in use, otherwise the one seen least
+            // recently.
+        pr = &recent_codes[0];
+        for (i = 1; i < RF433ANY_RECENT_CODES; ++i) {
+            recent_code_t *p = &recent_codes[i];
+            if (pr->encoding != RF433ANY_ID_RAW_INCONSISTENT
+                    && (p->encoding == RF433ANY_ID_RAW_INCONSISTENT
+                        || t - p->last_seen > t - pr->last_seen)) {
+                pr = p;
             }
-            pdec = nullptr;
         }
+        pr->hash = hash;
+        pr->encoding = id;
+        pr->was_recent = false;
     }
+    pr->last_seen = t;
+    pr->in_reception = true;
+}
 
-    return pdec_head;
+    // Called when get_data() is to work on another reception.
+void Track::recent_new_reception() {
+    if (!recent_recorded)
+        return;
+    for (byte i = 0; i < RF433ANY_RECENT_CODES; ++i)
+        recent_codes[i].in_reception = false;
+    recent_recorded = false;
 }
+#endif
 
 Decoder* Track::get_data(uint16_t filter, byte convention) {
     Decoder *pdec0 = get_data_core(convention);
     Decoder *prev_pdec = pdec0;
     Decoder *pdec = pdec0;
+#ifdef RF433ANY_RECENT_CODES
+    uint32_t t = millis();
+        // The codes of a reception get recorded once, before any filter, so
+        // that all calls to get_data() see the same codes as recent, and that
+        // the copies of a code count.
+    if (!recent_recorded) {
+        for (Decoder *p = pdec0; p; p = p->get_next()) {
+            if (p->data_got_decoded() && p->get_pdata()
+                    && p->get_pdata()->get_nb_bits()) {
+                record_recent(p, t);
+            }
+        }
+        recent_recorded = true;
+    }
+#endif
 
     while (pdec) {
         pdec->reset_repeats();
@@ -1791,6 +3645,16 @@ Decoder* Track::get_data(uint16_t filter, byte convention) {
                 keep = false;
         }
 
+#ifdef RF433ANY_RECENT_CODES
+        if ((filter & RF433ANY_FD_NOT_RECENT) && keep && recent_window) {
+            if (pdec->data_got_decoded() && pdec->get_pdata()
+                    && pdec->get_pdata()->get_nb_bits()
+                    && is_recent(pdec, t)) {
+                keep = false;
+            }
+        }
+#endif
+
         if (keep) {
             prev_pdec = pdec;
             pdec = pdec->get_next();
@@ -1811,63 +3675,221 @@ Decoder* Track::get_data(uint16_t filter, byte convention) {
         }
     }
 
+    if (filter & RF433ANY_FD_VOTE)
+        majority_vote(pdec0);
+
     return pdec0;
 }
 
-callback_t* Track::get_tail(const callback_t* h) {
-    const callback_t* pc = h;
-    if (pc) {
-        while (pc->next)
-            pc = pc->next;
-    }
-    return (callback_t*)pc;
+#ifdef RF433ANY_CALLBACK_INDEX
+    // Appends pc to its bucket
+void Track::index_callback(callback_t *pc) {
+    callback_t **ppc = &buckets[pc->hash & (nb_buckets - 1)];
+    while (*ppc)
+        ppc = &(*ppc)->next_in_bucket;
+    *ppc = pc;
+    pc->next_in_bucket = nullptr;
+}
+
+    // arg_nb_buckets must be a power of 2.
+    // The index is on the heap, also with RF433ANY_ARENA_SIZE: it changes
+    // only when a callback gets registered.
+void Track::build_callback_index(uint16_t arg_nb_buckets) {
+    free(buckets);
+    buckets = (callback_t**)calloc(arg_nb_buckets, sizeof(callback_t*));
+    assert(buckets);
+    nb_buckets = arg_nb_buckets;
+    for (callback_t *pc = head; pc; pc = pc->next)
+        index_callback(pc);
 }
+#endif
 
 void Track::setopt_wait_free_433_before_calling_callbacks(const bool val) {
     opt_wait_free_433_before_calling_callbacks = val;
 }
 
+    // Copies the entry i of a code book, from flash on AVR and ESP8266
+void codebook_get_entry(const codebook_entry_t *table, uint16_t i,
+        codebook_entry_t *pentry) {
+#if defined(__AVR__) || defined(ESP8266)
+    memcpy_P(pentry, &table[i], sizeof(*pentry));
+#else
+    *pentry = table[i];
+#endif
+}
+
+    // Returns the index of the first entry of a code book that has nb_bits and
+    // code, nb_entries if there is none.
+uint16_t codebook_find(const codebook_entry_t *table, uint16_t nb_entries,
+        byte nb_bits, uint32_t code) {
+    codebook_entry_t entry;
+    uint16_t lo = 0;
+    uint16_t hi = nb_entries;
+        // Binary search of the first entry not less than (nb_bits, code)
+    while (lo < hi) {
+        uint16_t mid = lo + ((hi - lo) >> 1);
+        codebook_get_entry(table, mid, &entry);
+        if (entry.nb_bits < nb_bits ||
+                (entry.nb_bits == nb_bits && entry.code < code)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < nb_entries) {
+        codebook_get_entry(table, lo, &entry);
+        if (entry.nb_bits == nb_bits && entry.code == code)
+            return lo;
+    }
+    return nb_entries;
+}
+
+    // Calls the callbacks of the decoded code of pdec that have the mask pmask
+    // (no mask if pmask is nullptr).
+void Track::call_callbacks(const Decoder *pdec, const BitVector *pmask,
+        uint32_t t0, bool *pflag_call_wait_free_433) {
+    const BitVector *pdata = pdec->get_pdata();
+#ifdef RF433ANY_CALLBACK_INDEX
+    uint32_t hash = pdata->get_hash(pmask);
+    for (callback_t *pc = buckets[hash & (nb_buckets - 1)]; pc;
+            pc = pc->next_in_bucket) {
+        if (pc->hash != hash)
+            continue;
+#else
+    for (callback_t *pc = head; pc; pc = pc->next) {
+#endif
+#ifdef RF433ANY_MASKED_CALLBACKS
+        if (pc->pmask != pmask)
+            continue;
+#endif
+        if (pc->encoding != RF433ANY_ID_ANY_ENCODING &&
+                pdec->get_id() != pc->encoding)
+            continue;
+        if (pmask ? !pdata->matches(pc->pcode, pmask) : pdata->cmp(pc->pcode))
+            continue;
+
+        if (!pc->min_delay_between_two_calls ||
+                !pc->last_trigger ||
+                t0 >= pc->last_trigger + pc->min_delay_between_two_calls) {
+            if (*pflag_call_wait_free_433) {
+                wait_free_433();
+                *pflag_call_wait_free_433 = false;
+            }
+            pc->last_trigger = t0;
+            pc->func(pc->data);
+        }
+    }
+}
+
+#ifdef RF433ANY_CODEBOOK
+    // Calls the code book function for each entry of the decoded code of pdec
+void Track::call_codebook(const Decoder *pdec,
+        bool *pflag_call_wait_free_433) {
+    const BitVector *pdata = pdec->get_pdata();
+    if (pdata->get_nb_bits() > 32)
+        return;
+    byte nb_bits = pdata->get_nb_bits();
+    uint32_t code = pdata->get_uint32();
+
+    codebook_entry_t entry;
+    for (uint16_t i = codebook_find(codebook, codebook_nb_entries, nb_bits,
+                code); i < codebook_nb_entries; ++i) {
+        codebook_get_entry(codebook, i, &entry);
+        if (entry.nb_bits != nb_bits || entry.code != code)
+            break;
+        if (entry.encoding != RF433ANY_ID_ANY_ENCODING &&
+                pdec->get_id() != entry.encoding)
+            continue;
+
+        if (*pflag_call_wait_free_433) {
+            wait_free_433();
+            *pflag_call_wait_free_433 = false;
+        }
+        codebook_func(entry.action, codebook_data);
+    }
+}
+#endif
+
+    // For each code, the callbacks without mask are called first, then the
+    // ones with a mask, mask by mask (in the order each mask got registered
+    // first). For a given mask (or no mask), callbacks are called in the order
+    // they got registered. Then comes the code book, in the order of its
+    // entries.
 void Track::check_registered_callbacks() {
+#ifdef RF433ANY_CODEBOOK
+    if (!head && !codebook)
+        return;
+#else
+    if (!head)
+        return;
+#endif
+
     uint32_t t0 = millis();
 
     bool flag_call_wait_free_433 = opt_wait_free_433_before_calling_callbacks;
 
-    Decoder *pdec0 = get_data(RF433ANY_FD_DECODED | RF433ANY_FD_DEDUP);
+    Decoder *pdec0 = get_data(RF433ANY_FD_DECODED | RF433ANY_FD_DEDUP
+                              | RF433ANY_FD_NOT_RECENT);
     Decoder *pdec = pdec0;
     while (pdec) {
         const BitVector *pdata = pdec->get_pdata();
         assert(pdata); // Must be the case (RF433ANY_FD_DECODED in the call to
                        // get_data() above).
 
-        for (callback_t *pc = head; pc; pc = pc->next) {
-            if (pc->encoding == RF433ANY_ID_ANY_ENCODING ||
-                    pdec->get_id() == pc->encoding) {
-                if (!pdata->cmp(pc->pcode)) {
-                    if (!pc->min_delay_between_two_calls ||
-                            !pc->last_trigger ||
-                            t0 >=
-                                pc->last_trigger
-                                + pc->min_delay_between_two_calls
-                    ) {
-                        if (flag_call_wait_free_433) {
-                            wait_free_433();
-                            flag_call_wait_free_433 = false;
-                        }
-                        pc->last_trigger = t0;
-                        pc->func(pc->data);
-                    }
+        if (head) {
+            call_callbacks(pdec, nullptr, t0, &flag_call_wait_free_433);
+#ifdef RF433ANY_MASKED_CALLBACKS
+            for (callback_mask_t *pm = masks; pm; pm = pm->next) {
+                if (pm->pmask->get_nb_bits() == pdata->get_nb_bits()) {
+                    call_callbacks(pdec, pm->pmask, t0,
+                            &flag_call_wait_free_433);
                 }
             }
+#endif
         }
+#ifdef RF433ANY_CODEBOOK
+        if (codebook)
+            call_codebook(pdec, &flag_call_wait_free_433);
+#endif
 
         pdec = pdec->get_next();
     }
     delete pdec0;
 }
 
-void Track::register_callback(byte encoding, const BitVector *pcode, void *data,
-        void (*func)(void *data), uint32_t min_delay_between_two_calls) {
+#ifdef RF433ANY_CODEBOOK
+    // func is called with the action of each entry of the code book that
+    // matches a code received (see check_registered_callbacks()). There is no
+    // minimum delay between two calls. Registering another code book replaces
+    // the previous one.
+void Track::register_codebook(const codebook_entry_t *table,
+        uint16_t nb_entries, void (*func)(uint16_t action, void *data),
+        void *data) {
+    assert(table || !nb_entries);
+    assert(func);
+
+        // Entries must be sorted (see codebook_entry_t)
+    codebook_entry_t prev;
+    codebook_entry_t entry;
+    for (uint16_t i = 0; i < nb_entries; ++i) {
+        codebook_get_entry(table, i, &entry);
+        assert(entry.nb_bits <= 32);
+        assert(!i || prev.nb_bits < entry.nb_bits ||
+                (prev.nb_bits == entry.nb_bits && prev.code <= entry.code));
+        prev = entry;
+    }
+
+    codebook = table;
+    codebook_nb_entries = nb_entries;
+    codebook_func = func;
+    codebook_data = data;
+}
+#endif
 
+    // Returns a new callback record, not yet registered
+callback_t *Track::new_callback(byte encoding, const BitVector *pcode,
+        void *data, void (*func)(void *data),
+        uint32_t min_delay_between_two_calls) {
     assert(encoding == RF433ANY_ID_ANY_ENCODING ||
             encoding == RF433ANY_ID_TRIBIT ||
             encoding == RF433ANY_ID_TRIBIT_INV ||
@@ -1875,23 +3897,99 @@ void Track::register_callback(byte encoding, const BitVector *pcode, void *data,
     assert(pcode);
     assert(func);
 
+#ifdef RF433ANY_ARENA_SIZE
+    callback_t *pc =
+        (callback_t*)RF433any_arena.alloc_permanent(sizeof(callback_t));
+#else
     callback_t *pc = new callback_t;
+#endif
     pc->encoding = encoding;
     pc->pcode = pcode;
+#ifdef RF433ANY_MASKED_CALLBACKS
+    pc->pmask = nullptr;
+#endif
     pc->data = data;
     pc->func = func;
     pc->min_delay_between_two_calls = min_delay_between_two_calls;
     pc->last_trigger = 0;
     pc->next = nullptr;
+    return pc;
+}
 
-    callback_t *tail = get_tail(head);
+    // Appends pc to the callbacks (and to the index, if any)
+void Track::add_callback(callback_t *pc) {
     if (tail) {
         tail->next = pc;
     } else {
         head = pc;
     }
+    tail = pc;
+
+#ifdef RF433ANY_CALLBACK_INDEX
+#ifdef RF433ANY_MASKED_CALLBACKS
+    pc->hash = pc->pcode->get_hash(pc->pmask);
+#else
+    pc->hash = pc->pcode->get_hash();
+#endif
+    ++nb_callbacks;
+    if (nb_callbacks > nb_buckets && nb_buckets < 0x8000) {
+        build_callback_index(nb_buckets ? nb_buckets << 1
+                                        : RF433ANY_CB_MIN_BUCKETS);
+        return;
+    }
+    index_callback(pc);
+#endif
 }
 
+    // IMPORTANT
+    //   The code pointed to by pcode must not change once registered.
+void Track::register_callback(byte encoding, const BitVector *pcode, void *data,
+        void (*func)(void *data), uint32_t min_delay_between_two_calls) {
+    add_callback(new_callback(encoding, pcode, data, func,
+                min_delay_between_two_calls));
+}
+
+#ifdef RF433ANY_MASKED_CALLBACKS
+    // Returns the recorded mask equal to *pmask, recording pmask if there is
+    // none.
+const BitVector *Track::record_mask(const BitVector *pmask) {
+    callback_mask_t **ppm = &masks;
+    for ( ; *ppm; ppm = &(*ppm)->next) {
+        if (!(*ppm)->pmask->cmp(pmask))
+            return (*ppm)->pmask;
+    }
+
+#ifdef RF433ANY_ARENA_SIZE
+    callback_mask_t *pm = (callback_mask_t*)RF433any_arena.alloc_permanent(
+            sizeof(callback_mask_t));
+#else
+    callback_mask_t *pm = new callback_mask_t;
+#endif
+    pm->pmask = pmask;
+    pm->next = nullptr;
+    *ppm = pm;
+    return pmask;
+}
+
+    // With pmask, the callback is called for the codes that have the same
+    // number of bits as *pcode and *pmask, and the same bits as *pcode where
+    // *pmask has bits set. For example, to match the first 8 bits received of
+    // 24-bit codes, *pmask has 24 bits, the first 8 ones being set.
+    // IMPORTANT
+    //   The codes pointed to by pcode and pmask must not change once
+    //   registered.
+void Track::register_callback(byte encoding, const BitVector *pcode,
+        const BitVector *pmask, void *data, void (*func)(void *data),
+        uint32_t min_delay_between_two_calls) {
+    assert(!pmask || (pcode && pmask->get_nb_bits() == pcode->get_nb_bits()));
+
+    callback_t *pc = new_callback(encoding, pcode, data, func,
+            min_delay_between_two_calls);
+    pc->pmask = (pmask ? record_mask(pmask) : nullptr);
+    add_callback(pc);
+}
+#endif
+
 #ifdef RF433ANY_DBG_TIMINGS
 void Track::dbg_timings() const {
     for (unsigned int i = 0; i + 1 < ih_dbg_pos; i += 2) {
@@ -1910,7 +4008,7 @@ const char* trk_names[] = {
 void Track::track_debug() const {
     recorded_t xorval = r_low.rec ^ r_high.rec;
     dbgf("    \"trk\":%s,\"xorval\":0x" FMTRECORDEDT ",",
-         trk_names[trk], xorval);
+         trk_names[trk], RECORDEDT_ARG(xorval));
     if (trk != TRK_WAIT) {
         for (byte i = 0; i < 2; ++i) {
             dbgf("    \"%s\":{", (i == 0 ? "r_low" : "r_high"));
@@ -27,16 +27,20 @@
 
 #define RF433ANY_DBG_SIMULATE
 #define RF433ANY_DBG_TRACK
+#define RF433ANY_RAIL_LUT
 
 #elif RF433ANY_TESTPLAN == 2 // RF433ANY_TESTPLAN
 
 #define RF433ANY_DBG_SIMULATE
 #define RF433ANY_DBG_RAWCODE
+#define RF433ANY_IH_BATCH
 
 #elif RF433ANY_TESTPLAN == 3 // RF433ANY_TESTPLAN
 
 #define RF433ANY_DBG_SIMULATE
 #define RF433ANY_DBG_DECODER
+#define RF433ANY_RAIL_LUT
+#define RF433ANY_ADAPTIVE_ORDER
 
 #elif RF433ANY_TESTPLAN == 4 // RF433ANY_TESTPLAN
 
@@ -49,6 +53,99 @@
 
 #define RF433ANY_DBG_SIMULATE
 #define RF433ANY_DBG_SMALL_RECORDED
+#define RF433ANY_INCREMENTAL_DECODING
+
+#elif RF433ANY_TESTPLAN == 6 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+
+#elif RF433ANY_TESTPLAN == 7 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_IDLE_TIMEOUT
+
+#elif RF433ANY_TESTPLAN == 8 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_IDLE_TIMEOUT
+#define RF433ANY_STREAM
+
+#elif RF433ANY_TESTPLAN == 9 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_MULTI_BANDS
+
+#elif RF433ANY_TESTPLAN == 10 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+
+#elif RF433ANY_TESTPLAN == 11 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+    // Decoders are about three times as big on 32- and 64-bit platforms
+#if defined(__AVR__)
+#define RF433ANY_ARENA_SIZE 512
+#else
+#define RF433ANY_ARENA_SIZE 1536
+#endif
+
+#elif RF433ANY_TESTPLAN == 12 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_CALLBACK_INDEX
+#define RF433ANY_MASKED_CALLBACKS
+
+#elif RF433ANY_TESTPLAN == 13 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_CODEBOOK
+
+#elif RF433ANY_TESTPLAN == 14 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_RECENT_CODES 2
+
+#elif RF433ANY_TESTPLAN == 15 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+
+#elif RF433ANY_TESTPLAN == 16 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_RECENT_CODES 2
+
+#elif RF433ANY_TESTPLAN == 17 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_IH_STORM_GUARD
+
+#elif RF433ANY_TESTPLAN == 18 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_IH_SQUELCH
+
+#elif RF433ANY_TESTPLAN == 19 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_RAWCODE_QUEUE 2
+
+#elif RF433ANY_TESTPLAN == 20 // RF433ANY_TESTPLAN
+
+#define RF433ANY_DBG_SIMULATE
+#define RF433ANY_DBG_DECODER
+#define RF433ANY_ADAPTIVE_BANDS
 
 #else // RF433ANY_TESTPLAN
 
@@ -70,6 +167,29 @@
 //#define RF433ANY_DBG_DECODER
 //#define RF433ANY_DBG_SMALL_RECORDED
 
+    // Options, described further below and in README.md.
+    // IMPORTANT
+    //   Set them here, or with a compiler flag given for every file, not in
+    //   the sketch before including RF433any.h: RF433any.cpp is compiled on
+    //   its own and would not see them, the sketch and the library then
+    //   disagreeing on the layout of Track.
+#define RF433ANY_IH_BATCH
+//#define RF433ANY_IH_STORM_GUARD
+//#define RF433ANY_IDLE_TIMEOUT
+//#define RF433ANY_STREAM
+#define RF433ANY_ADAPTIVE_ORDER
+#define RF433ANY_CALLBACK_INDEX
+//#define RF433ANY_MASKED_CALLBACKS
+//#define RF433ANY_CODEBOOK
+//#define RF433ANY_RAWCODE_QUEUE 2
+//#define RF433ANY_INCREMENTAL_DECODING
+//#define RF433ANY_RECORDED_BITS 64
+//#define RF433ANY_RAIL_LUT
+//#define RF433ANY_ADAPTIVE_BANDS
+//#define RF433ANY_MULTI_BANDS
+//#define RF433ANY_ARENA_SIZE 2048
+//#define RF433ANY_RECENT_CODES 4
+
 #endif // RF433ANY_TESTPLAN
 
 #if defined(RF433ANY_DBG_SIMULATE) || defined(RF433ANY_DBG_TRACE) \
@@ -112,6 +232,13 @@ uint16_t uncompact(duration_t b);
 #define RF433ANY_MAX_SEP_DURATION 65535
 #ifndef RF433ANY_MAX_SECTIONS
 #define RF433ANY_MAX_SECTIONS     8
+#endif
+    // Number of received codes that can wait to be processed (by get_data()
+    // or callbacks) while reception goes on. 0 means recording stops as soon
+    // as a code is received, until treset() is called.
+    // Each one costs sizeof(RawCode) bytes of RAM.
+#ifndef RF433ANY_RAWCODE_QUEUE
+#define RF433ANY_RAWCODE_QUEUE    0
 #endif
 
 
@@ -125,6 +252,12 @@ uint16_t uncompact(duration_t b);
     //   That means BAND_MAX_D must be lower than 32768.
 #define BAND_MAX_D 30000
 
+    // Define RF433ANY_ADAPTIVE_BANDS to have the bands of a rail follow the
+    // durations received, instead of being anchored on the first one: mid is
+    // the running mean of the durations received in the band, and the
+    // tolerance window widens (from 25% up to 37.5% of mid) if they spread.
+    // Costs 9 bytes of RAM per band (6 bands per Track).
+
 struct Band {
     uint16_t inf;
     uint16_t mid;
@@ -132,6 +265,18 @@ struct Band {
 
     bool got_it;
 
+#ifdef RF433ANY_ADAPTIVE_BANDS
+        // Running mean and mean absolute deviation of the durations received
+        // in the band, with 4 fractional bits, and number of durations
+        // (saturates at 255).
+    uint32_t mean_fp;
+    uint32_t dev_fp;
+    byte nb;
+
+    void add_sample(uint16_t d);
+    uint16_t get_halfwidth() const;
+#endif
+
     bool test_value_init_if_needed(uint16_t d);
     bool test_value(uint16_t d);
 
@@ -145,25 +290,56 @@ struct Band {
 // * Rail *********************************************************************
 // * **** *********************************************************************
 
-#ifdef RF433ANY_DBG_SIMULATE
+    // Number of bits a rail can record (8, 16, 32 or 64). A code having more
+    // bits is recorded in several sections (the first ones terminated with
+    // status STS_CONTINUED), see RF433ANY_MAX_SECTIONS.
+    // The wider, the more RAM each section takes (and the more time shifts
+    // take on 8-bit MCUs). The default is 16 bits on AVR and 32 bits
+    // elsewhere.
+    // NOTE
+    //   The width can change the result when a code ends in error (no
+    //   separator after its last bit): the last section is then discarded
+    //   (see the decision table in Track::track_eat_recv()). With narrow
+    //   rails, the bits before the error can already be in sections
+    //   terminated as STS_CONTINUED, that are kept. With wider rails, they can
+    //   all be in the last section, and get lost (test plan round 3, test
+    //   decoder/24, loses its second section at 64 bits).
+#ifndef RF433ANY_RECORDED_BITS
 
+#ifdef RF433ANY_DBG_SIMULATE
 #ifdef RF433ANY_DBG_SMALL_RECORDED
-
-typedef uint8_t recorded_t;
-#define FMTRECORDEDT "%02X"
-
+#define RF433ANY_RECORDED_BITS 8
 #else
-
-typedef uint32_t recorded_t;
-#define FMTRECORDEDT "%08lX"
-
+#define RF433ANY_RECORDED_BITS 32
+#endif
+#elif defined(__AVR__)
+#define RF433ANY_RECORDED_BITS 16
+#else
+#define RF433ANY_RECORDED_BITS 32
 #endif
 
-#else // RF433ANY_DBG_SIMULATE
+#endif // RF433ANY_RECORDED_BITS
 
+    // RECORDEDT_ARG() gives the argument(s) to print a recorded_t with
+    // FMTRECORDEDT.
+#if RF433ANY_RECORDED_BITS == 8
+typedef uint8_t recorded_t;
+#define FMTRECORDEDT "%02X"
+#define RECORDEDT_ARG(v) (v)
+#elif RF433ANY_RECORDED_BITS == 16
 typedef uint16_t recorded_t;
 #define FMTRECORDEDT "%04lx"
-
+#define RECORDEDT_ARG(v) (v)
+#elif RF433ANY_RECORDED_BITS == 32
+typedef uint32_t recorded_t;
+#define FMTRECORDEDT "%08lX"
+#define RECORDEDT_ARG(v) (v)
+#elif RF433ANY_RECORDED_BITS == 64
+typedef uint64_t recorded_t;
+#define FMTRECORDEDT "%08lX%08lX"
+#define RECORDEDT_ARG(v) (unsigned long)((v) >> 32), (unsigned long)(v)
+#else
+#error "RF433ANY_RECORDED_BITS must be 8, 16, 32 or 64."
 #endif
 
 #define RAIL_MOOD_STRICT 0
@@ -177,6 +353,62 @@ typedef uint16_t recorded_t;
 #define RAIL_CLOSED   3
 #define RAIL_ERROR    4
 
+    // Define RF433ANY_MULTI_BANDS to receive codes that have more than two
+    // durations (PWM or PPM with 3 or 4 pulse widths): each rail can then
+    // have up to RF433ANY_MAX_BANDS bands, instead of b_short and b_long only.
+    // Each timing is recorded as a symbol, the rank of its band (0 for the
+    // shortest), in two bit planes (rec and rec2). Codes with more than two
+    // bands are decoded by DecoderMultiWidth.
+    // The tolerance of each band is 31%, reduced so that bands don't overlap.
+    // A duration out of all bands creates a new band if its ratio to every
+    // band known is 1.4 or more, otherwise (RAIL_MOOD_LAXIST mood) it goes to
+    // the nearest band, so that codes having two bands decode as usual.
+#ifdef RF433ANY_MULTI_BANDS
+
+#ifndef RF433ANY_MAX_BANDS
+#define RF433ANY_MAX_BANDS 4
+#endif
+#if RF433ANY_MAX_BANDS < 3 || RF433ANY_MAX_BANDS > 4
+#error "RF433ANY_MAX_BANDS must be 3 or 4."
+#endif
+#ifdef RF433ANY_ADAPTIVE_BANDS
+#error "RF433ANY_MULTI_BANDS cannot be used with RF433ANY_ADAPTIVE_BANDS."
+#endif
+#ifdef RF433ANY_RAIL_LUT
+#error "RF433ANY_MULTI_BANDS cannot be used with RF433ANY_RAIL_LUT."
+#endif
+
+#endif // RF433ANY_MULTI_BANDS
+
+    // Define RF433ANY_RAIL_LUT to have each rail, once its bands are known,
+    // classify durations with a lookup table indexed by compact(d), instead
+    // of comparing d with the boundaries of the bands. Costs a table of 64
+    // bytes per rail, that is, 128 bytes of RAM per Track (2 rails), plus a
+    // flag per rail.
+#ifdef RF433ANY_RAIL_LUT
+
+#ifdef RF433ANY_DBG_NO_COMPACT_DURATIONS
+#error "RF433ANY_RAIL_LUT requires compacted durations."
+#endif
+#ifdef RF433ANY_ADAPTIVE_BANDS
+#error "RF433ANY_RAIL_LUT and RF433ANY_ADAPTIVE_BANDS cannot be used together."
+#endif
+
+    // Classes of durations. RAIL_LUT_OTHER covers durations that terminate
+    // the rail with an error, and the compacted durations that span the
+    // boundary of a band: these ones are classified by comparisons.
+#define RAIL_LUT_OTHER 0
+#define RAIL_LUT_SHORT 1
+#define RAIL_LUT_LONG  2
+#define RAIL_LUT_SEP   3
+
+    // The table gets built once a rail has recorded RAIL_LUT_MIN_BITS bits,
+    // so that noise does not cost a build each time it looks like the
+    // beginning of a code.
+#define RAIL_LUT_MIN_BITS 7
+
+#endif // RF433ANY_RAIL_LUT
+
 class Rail {
     friend class Track;
 
@@ -192,6 +424,41 @@ class Rail {
 
         byte mood;
 
+#ifdef RF433ANY_MULTI_BANDS
+            // Bands found after b_short and b_long, in the order they were
+            // found (their symbols are 2 and 3 until ranked by
+            // get_symbols()).
+        Band b_extra[RF433ANY_MAX_BANDS - 2];
+        byte nb_extra;
+        recorded_t rec2;
+
+        byte eat_extra(uint16_t d);
+        void get_default_bands(Band *pshort, Band *plong) const;
+#endif
+
+#ifdef RF433ANY_RAIL_LUT
+        bool lut_ready;
+            // 2 bits (a RAIL_LUT_* class) per compacted duration
+        byte lut[64];
+
+        byte lut_get(duration_t c) const {
+            return (lut[c >> 2] >> ((c & 3) << 1)) & 3;
+        }
+        void lut_set(uint16_t c, byte v);
+        void lut_fill(uint16_t inf, uint16_t sup, byte v);
+        void lut_build();
+#ifdef RF433ANY_DBG_SIMULATE
+        byte lut_class_by_bands(uint16_t d) const;
+#endif
+#endif
+
+        void set_default_bounds(Band *pshort, Band *plong) const;
+        void set_bounds();
+#ifdef RF433ANY_ADAPTIVE_BANDS
+        void adapt_bands(uint16_t d);
+#endif
+        bool rail_eat_bands(uint16_t d);
+
     public:
         Rail(byte arg_mood);
         bool rail_eat(uint16_t d);
@@ -201,6 +468,9 @@ class Rail {
         void rail_debug() const;
 #endif
         byte get_band_count() const;
+#ifdef RF433ANY_MULTI_BANDS
+        void get_symbols(recorded_t *prec, recorded_t *prec2) const;
+#endif
 };
 
 
@@ -232,13 +502,31 @@ struct TimingsExt: public Timings {
     uint16_t last_low;
 };
 
+    // The number of bits of a rail can be 64, that does not fit in 6 bits.
+#if RF433ANY_RECORDED_BITS == 64
+#define SECTION_BITS_WIDTH 7
+#else
+#define SECTION_BITS_WIDTH 6
+#endif
+    // Same for the number of bands (4 with RF433ANY_MULTI_BANDS).
+#ifdef RF433ANY_MULTI_BANDS
+#define SECTION_BANDS_WIDTH 3
+#else
+#define SECTION_BANDS_WIDTH 2
+#endif
+
 struct Section {
     recorded_t low_rec;
-    unsigned char low_bits   :6;
-    unsigned char low_bands  :2;
+    unsigned char low_bits   :SECTION_BITS_WIDTH;
+    unsigned char low_bands  :SECTION_BANDS_WIDTH;
     recorded_t high_rec;
-    unsigned char high_bits  :6;
-    unsigned char high_bands :2;
+    unsigned char high_bits  :SECTION_BITS_WIDTH;
+    unsigned char high_bands :SECTION_BANDS_WIDTH;
+#ifdef RF433ANY_MULTI_BANDS
+        // High bit of the symbols (low bit in low_rec and high_rec)
+    recorded_t low_rec2;
+    recorded_t high_rec2;
+#endif
 
     uint16_t first_low;
     uint16_t first_high;
@@ -249,30 +537,160 @@ struct Section {
     section_term_status_t sts;
 };
 
+class Decoder;
+struct DecoderHits;
+
+    // Decoders being built out of the sections of a RawCode: head to tail is
+    // the list of completed decoders, pdec is the decoder of the section(s)
+    // not yet terminated (a section having status STS_CONTINUED is continued
+    // by the next one).
+    // phits (can be null) counts the decoders chosen, see DecoderHits.
+struct DecoderChain {
+    Decoder *head;
+    Decoder *tail;
+    Decoder *pdec;
+    DecoderHits *phits;
+
+    void init(DecoderHits *arg_phits = nullptr) {
+        head = nullptr;
+        tail = nullptr;
+        pdec = nullptr;
+        phits = arg_phits;
+    }
+    bool is_empty() const { return !head && !pdec; }
+    Decoder *decode_with_favorite(const Section *psec, byte convention);
+    void add_section(const Section *psec, uint16_t initseq, byte convention);
+    void close_pdec();
+    Decoder *take_closed();
+    Decoder *close();
+    void clear();
+};
+
+    // Define RF433ANY_INCREMENTAL_DECODING to decode each section as soon as
+    // it is recorded (in Track::track_eat()), instead of decoding all of
+    // them once the code is complete. Callbacks are then called earlier, at
+    // the cost of decoding (RAM allocation included) during reception.
+    // Only the default convention (RF433ANY_CONV0) is decoded in advance.
+
 struct RawCode {
     uint16_t initseq;
     uint16_t max_code_d;
     byte nb_sections;
     Section sections[RF433ANY_MAX_SECTIONS];
+#ifdef RF433ANY_INCREMENTAL_DECODING
+        // Decoders of the sections, not yet taken by Track::get_data_core()
+    DecoderChain chain;
+#endif
 
     void debug_rawcode() const;
 };
 
 
+// * ***** ********************************************************************
+// * Arena ********************************************************************
+// * ***** ********************************************************************
+
+    // Define RF433ANY_ARENA_SIZE (in bytes) to have decoders, their data
+    // (BitVector) and callback records (see register_callback()) taken from
+    // a fixed buffer of this size instead of the heap.
+    // Decoders and data are taken from the beginning of the buffer on, one
+    // after the other, like a stack: the space of a block released is reused
+    // once the blocks that come after it are released, too (normally, the
+    // caller of get_data() deletes all the decoders of a code at once).
+    // Callback records are taken from the end of the buffer and never
+    // released.
+    // If the buffer is full, the heap is used (see arena_stats_t), so the
+    // size must be chosen large enough for one code (get_stats() tells the
+    // highest use).
+    // IMPORTANT
+    //   A decoder kept, or data taken away from a decoder (see
+    //   Decoder::take_away_data()), keeps the space that comes after it from
+    //   being reused, until it gets deleted.
+
+#ifdef RF433ANY_ARENA_SIZE
+
+#if RF433ANY_ARENA_SIZE > 32767
+#error "RF433ANY_ARENA_SIZE must be lower than 32768."
+#endif
+
+#include <stddef.h>
+
+struct arena_stats_t {
+    uint16_t max_used;     // Highest number of bytes used
+    uint16_t nb_overflows; // Number of allocations done on the heap, the
+                           // buffer being full
+};
+
+class Arena {
+    private:
+        union {
+            byte bytes[RF433ANY_ARENA_SIZE];
+            max_align_t align;
+        } buf;
+            // Beginning of the free space (end of decoders and data) and end
+            // of the free space (beginning of callback records)
+        uint16_t top;
+        uint16_t bottom_of_permanent;
+            // Size of the last block (0 if none)
+        uint16_t last_size;
+        arena_stats_t stats;
+
+        void update_max_used();
+
+    public:
+        Arena();
+
+        void *alloc(size_t n);
+        void *resize(void *p, size_t n);
+        void release(void *p);
+        void *alloc_permanent(size_t n);
+
+        bool owns(const void *p) const {
+            return (const byte *)p >= buf.bytes
+                   && (const byte *)p < buf.bytes + RF433ANY_ARENA_SIZE;
+        }
+        uint16_t get_used() const { return top; }
+        void get_stats(arena_stats_t *pstats) const { *pstats = stats; }
+        void reset_stats();
+};
+
+extern Arena RF433any_arena;
+
+#endif // RF433ANY_ARENA_SIZE
+
+
 // * ********* ****************************************************************
 // * BitVector ****************************************************************
 // * ********* ****************************************************************
 
-// vector-like of the (very) poor man. No time to make it fancier.
-// It'll simply accept to add a bit at the beginning (add_bit),
-// to get the number of bits and bytes, and access the Nth bit or byte.
-// Also, an iterator would be best to walk through bits, but it is 'TO DO' for
-// now.
+// vector-like of the (very) poor man.
+// It'll simply accept to add bits at the beginning (add_bit, add_bits), to get
+// the number of bits and bytes, and access the Nth bit or byte (bit 0 being
+// the last one added), or the last 32 or 64 bits as an integer.
+//
+// Bits are stored in the order they got added, in words, the first bit added
+// being the most significant bit of words[0]. Adding a bit does not move the
+// others, and the storage grows by doubling its size.
+// Bits after the last one added are 0, so that comparing two BitVectors having
+// the same number of bits is comparing their words.
+
+    // On 8-bit MCUs, shifts of one byte are much cheaper.
+    // RF433ANY_DBG_SMALL_RECORDED uses bytes as well, so that the test plan
+    // covers them.
+#if defined(__AVR__) || defined(RF433ANY_DBG_SMALL_RECORDED)
+typedef uint8_t bitvector_word_t;
+#else
+typedef uint32_t bitvector_word_t;
+#endif
+#define BITVECTOR_WORD_BITS (sizeof(bitvector_word_t) << 3)
+    // Initial storage, in words (4 bytes)
+#define BITVECTOR_MIN_WORDS (4 / sizeof(bitvector_word_t))
+
 class BitVector {
     private:
-        uint8_t* array;
-        byte allocated;
-        byte nb_bits;
+        bitvector_word_t *words;
+        byte allocated;     // In words
+        uint16_t nb_bits;
     public:
         BitVector();
         BitVector(short arg_nb_bits, short arg_nb_bytes, byte b0, byte b1);
@@ -288,17 +706,41 @@ class BitVector {
         void prepare_BitVector_construction(short arg_nb_bits,
                 short arg_nb_bytes, short n);
 
-        virtual ~BitVector();
-
-        virtual void add_bit(byte v);
-
-        virtual int get_nb_bits() const;
-        virtual byte get_nb_bytes() const;
-        virtual byte get_nth_bit(byte n) const;
-        virtual byte get_nth_byte(byte n) const;
+        ~BitVector();
+
+        void add_bit(byte v);
+        void add_bits(recorded_t v, byte n);
+
+        int get_nb_bits() const { return nb_bits; }
+        uint16_t get_nb_bytes() const { return (nb_bits + 7) >> 3; }
+        byte get_nth_bit(uint16_t n) const;
+        void set_nth_bit(uint16_t n, byte v);
+        byte get_nth_byte(uint16_t n) const;
+        uint32_t get_uint32() const;
+        uint64_t get_uint64() const;
+        uint32_t get_hash(const BitVector *pmask = nullptr) const;
+
+        char *to_str() const;
+        short cmp(const BitVector *p) const;
+        bool matches(const BitVector *pvalue, const BitVector *pmask) const;
+        uint16_t distance(const BitVector *p) const;
+
+#ifdef RF433ANY_ARENA_SIZE
+            // The data of decoders is in RF433any_arena (see Decoder()), as
+            // its bytes, other BitVector objects being on the heap.
+        static void *operator new(size_t sz) { return malloc(sz); }
+        static void *operator new(size_t sz, Arena& arena) {
+            return arena.alloc(sz);
+        }
+        static void operator delete(void *p) { RF433any_arena.release(p); }
+#endif
 
-        virtual char *to_str() const;
-        virtual short cmp(const BitVector *p) const;
+    private:
+        void *realloc_words(size_t sz);
+        void free_words();
+        void reserve(uint16_t n);
+        void add_bytes(short arg_nb_bits, const byte *b, byte n);
+        uint32_t get_bits(int first, byte len) const;
 };
 
 
@@ -329,6 +771,14 @@ enum class Signal {
 #define RF433ANY_FD_TRI       8
 #define RF433ANY_FD_TRN      16
 #define RF433ANY_FD_MAN      32
+    // Without effect if RF433ANY_RECENT_CODES is not defined
+#define RF433ANY_FD_NOT_RECENT 64
+    // See Track::majority_vote()
+#define RF433ANY_FD_VOTE     128
+
+    // Copies of a code that differ by more than 1 / RF433ANY_VOTE_MAX_DIFF of
+    // their bits are taken as different codes by RF433ANY_FD_VOTE.
+#define RF433ANY_VOTE_MAX_DIFF 4
 
 #define RF433ANY_ID_RAW_INCONSISTENT   0
 #define RF433ANY_ID_START              1 // Start enumeration of real decoders
@@ -339,13 +789,22 @@ enum class Signal {
 #define RF433ANY_ID_RAW_UNKNOWN_CODING 5 // At last we use this one, that'll
                                          // always produce a successful result.
 #define RF433ANY_ID_END                5 // End of enumeration of real decoders
+#define RF433ANY_ID_MULTI_WIDTH        6 // RF433ANY_MULTI_BANDS only
 
 #define RF433ANY_ID_ANY_ENCODING      99
 
+    // DecoderTriBit, DecoderTriBitInv and DecoderManchester decode the
+    // recorded bits of a section (low_rec and high_rec) a word at a time
+    // (see decode_rec()), instead of calling add_signal_step() for each
+    // signal step. They fall back to the latter when a section has errors.
+    // Define RF433ANY_DBG_NO_WORD_DECODING to always decode step by step.
+//#define RF433ANY_DBG_NO_WORD_DECODING
+
 class Decoder {
     private:
         Decoder *next;
         byte repeats;
+        byte confidence;
 
     protected:
         BitVector* pdata;
@@ -355,15 +814,34 @@ class Decoder {
         TimingsExt tsext;
 
         void add_data_bit(byte valbit);
+        void add_data_bits(recorded_t bits, byte n);
         virtual void add_signal_step(Signal low, Signal high) = 0;
+        void add_signal_step_at(const Section *psec, byte *ppos_low,
+                                byte *ppos_high);
+        void add_signal_steps(const Section *psec, byte pos_low,
+                              byte pos_high);
+        virtual void decode_rec(const Section *psec);
+#ifdef RF433ANY_DBG_SIMULATE
+        void dbg_check_same_bits(const Decoder *pref,
+                                 int nb_bits_before) const;
+#endif
 
     public:
         Decoder(byte arg_convention);
         virtual ~Decoder();
+
+#ifdef RF433ANY_ARENA_SIZE
+        static void *operator new(size_t sz) {
+            return RF433any_arena.alloc(sz);
+        }
+        static void operator delete(void *p) { RF433any_arena.release(p); }
+#endif
         virtual byte get_id() const = 0;
         virtual char get_id_letter() const = 0;
 
         static Decoder *build_decoder(byte id, byte convention);
+        static bool first_signal_step(const Section *psec, Signal *plo,
+                                      Signal *phi);
 
         virtual void add_sync(byte n) { }
         virtual byte get_nb_errors() const;
@@ -388,6 +866,9 @@ class Decoder {
         virtual void reset_repeats() { repeats = 0; }
         virtual void inc_repeats() { ++repeats; }
         virtual byte get_repeats() const { return repeats; };
+            // In percent, see Track::majority_vote()
+        byte get_confidence() const { return confidence; }
+        void vote(byte nb);
 
 #ifdef RF433ANY_DBG_DECODER
         virtual void dbg_data(byte seq) const;
@@ -498,6 +979,9 @@ class DecoderTriBit: public Decoder {
         virtual char get_id_letter() const override { return 'T'; }
         virtual void add_signal_step(Signal low, Signal high)
             override;
+#ifndef RF433ANY_DBG_NO_WORD_DECODING
+        virtual void decode_rec(const Section *psec) override;
+#endif
 
         virtual bool data_got_decoded() const override {
             return pdata && pdata->get_nb_bits();
@@ -532,6 +1016,9 @@ class DecoderTriBitInv: public Decoder {
         virtual char get_id_letter() const override { return 'N'; }
         virtual void add_signal_step(Signal low, Signal high)
             override;
+#ifndef RF433ANY_DBG_NO_WORD_DECODING
+        virtual void decode_rec(const Section *psec) override;
+#endif
 
         virtual bool data_got_decoded() const override {
             return pdata && pdata->get_nb_bits();
@@ -572,6 +1059,50 @@ class DecoderManchester: public Decoder {
         virtual char get_id_letter() const override { return 'M'; }
         virtual void add_signal_step(Signal low, Signal high)
             override;
+#ifndef RF433ANY_DBG_NO_WORD_DECODING
+        virtual void decode_rec(const Section *psec) override;
+#endif
+
+        virtual bool data_got_decoded() const override {
+            return pdata && pdata->get_nb_bits();
+        }
+
+#ifdef RF433ANY_DBG_DECODER
+        virtual void dbg_decoder(byte disp_level, byte seq) const override;
+#endif
+
+};
+
+
+#ifdef RF433ANY_MULTI_BANDS
+
+// * ***************** ********************************************************
+// * DecoderMultiWidth ********************************************************
+// * ***************** ********************************************************
+
+    // Decodes sections having more than two bands on a rail (see
+    // RF433ANY_MULTI_BANDS). Each low then each high timing gives a 2-bit
+    // symbol (the rank of its duration, 0 for the shortest), added to data
+    // most significant bit first. A rail having one band only (the constant
+    // pulse of PPM) carries no information and is skipped.
+    // The first low and high of a section are not part of data (see U and V
+    // in dbg_meta()).
+class DecoderMultiWidth: public Decoder {
+    private:
+        void add_symbol(recorded_t rec, recorded_t rec2, byte pos);
+
+    public:
+        DecoderMultiWidth(): Decoder(RF433ANY_CONV0) { }
+        ~DecoderMultiWidth() { }
+
+        virtual byte get_id() const override {
+            return RF433ANY_ID_MULTI_WIDTH;
+        }
+        virtual char get_id_letter() const override { return 'W'; }
+        virtual void add_signal_step(Signal lo, Signal hi) override { }
+
+        virtual void decode_section(const Section *psec,
+                bool is_cont_of_prev_sec) override;
 
         virtual bool data_got_decoded() const override {
             return pdata && pdata->get_nb_bits();
@@ -583,6 +1114,66 @@ class DecoderManchester: public Decoder {
 
 };
 
+#endif // RF433ANY_MULTI_BANDS
+
+
+// * ************ *************************************************************
+// * DecoderProbe *************************************************************
+// * ************ *************************************************************
+
+    // The errors of DecoderRawSync, DecoderTriBit, DecoderTriBitInv and
+    // DecoderManchester, fed side by side with the signal steps of a section,
+    // in one pass. This way DecoderChain::add_section() builds one decoder
+    // only, the first one of the enumeration that has no error (instead of
+    // building and deleting each of them in turn).
+    // Only tells whether there is an error: a decoder stops being fed as soon
+    // as it has one.
+struct DecoderProbe {
+        // Bit N is set when decoder of id N has an error
+    byte failed;
+
+        // DecoderRawSync
+    Signal sync_shape;
+    bool sync_shape_set;
+        // DecoderTriBitInv
+    bool tbi_first_step;
+    Signal tbi_last_hi;
+        // DecoderManchester
+    byte man_buf[3];
+    byte man_buf_pos;
+    bool man_leading_passed;
+
+    void init();
+    void fail(byte id) { failed |= (1 << id); }
+    bool has_failed(byte id) const { return failed & (1 << id); }
+    void man_add_buf(byte r);
+    void add_signal_step(Signal lo, Signal hi);
+    byte probe_section(const Section *psec);
+
+    static byte word_failures(const Section *psec);
+};
+
+    // Number of sections each decoder got chosen for (indexed by decoder id),
+    // recent sections weighing more: all counts are halved when one of them
+    // reaches 255.
+    // DecoderChain::add_section() first tries the favorite decoder (the one
+    // having the highest count among DecoderTriBit, DecoderTriBitInv and
+    // DecoderManchester), and uses DecoderProbe only if it fails. The favorite
+    // is tried only if DecoderProbe::word_failures() tells the decoders that
+    // come before it in the enumeration fail, therefore the decoder chosen
+    // does not depend on the counts: it is always the first one of the
+    // enumeration that has no error, DecoderRawUnknownCoding being the last.
+    // Track counts the decoders chosen if RF433ANY_ADAPTIVE_ORDER is defined
+    // (it is, in the configuration block at the top of this file), otherwise
+    // DecoderProbe is always used.
+struct DecoderHits {
+    byte hits[RF433ANY_ID_END + 1];
+
+    void reset();
+    void hit(byte id);
+    byte get_favorite() const;
+};
+
 
 // * ***** ********************************************************************
 // * Track ********************************************************************
@@ -592,12 +1183,28 @@ class DecoderManchester: public Decoder {
 #define TRACK_MIN_BITS             7
 
     // IMPORTANT
-    //   IH_MASK must be equal to the size of IH_timings - 1.
-    //   The size of IH_timings must be a power of 2.
-    //   Thus, IH_MASK allows to quickly calculate modulo, while walking through
-    //   IH_timings.
-#define IH_SIZE 4
-#define IH_MASK (IH_SIZE - 1)
+    //   RF433ANY_IH_SIZE is the size of the timings ring filled by the
+    //   interrupt handler. It must be a power of 2, between 2 and 128.
+    //   One slot is always left unused, so the ring can hold at most
+    //   RF433ANY_IH_SIZE - 1 pending timings.
+#ifndef RF433ANY_IH_SIZE
+#define RF433ANY_IH_SIZE 4
+#endif
+
+    // What to do when the interrupt handler has a new timing to record, while
+    // the ring is full (the main loop did not call do_events() often enough).
+#define RF433ANY_IH_DROP_OLDEST 0 // Loose the oldest timing in ring
+#define RF433ANY_IH_DROP_NEWEST 1 // Loose the timing just measured
+#define RF433ANY_IH_ABORT_FRAME 2 // Empty the ring and reset Track
+#ifndef RF433ANY_IH_OVERFLOW_POLICY
+#define RF433ANY_IH_OVERFLOW_POLICY RF433ANY_IH_DROP_OLDEST
+#endif
+
+    // If RF433ANY_IH_BATCH is defined (it is, in the configuration block at
+    // the top of this file), process_interrupt_timings() copies all pending
+    // timings out of the ring in one critical section, at the cost of
+    // RF433ANY_IH_SIZE timings of RAM per Track. Otherwise, it takes them one
+    // at a time, as process_interrupt_timing() does.
 
 struct IH_timing_t {
     byte r;
@@ -610,6 +1217,316 @@ struct IH_timing_t {
     }
 };
 
+struct IH_stats_t {
+    byte max_pending;           // High-water mark of pending timings
+    uint16_t nb_dropped;        // Timings lost because the ring was full
+    uint16_t nb_aborted_frames; // Frames aborted (RF433ANY_IH_ABORT_FRAME)
+};
+
+// Single-producer (interrupt handler), single-consumer (main loop) ring of
+// timings.
+//
+// NOTE
+//   With the RF433ANY_IH_DROP_NEWEST and RF433ANY_IH_ABORT_FRAME policies, the
+//   producer only ever updates write_head and the consumer only ever updates
+//   read_head, therefore pop() needs no critical section.
+//   With RF433ANY_IH_DROP_OLDEST, the producer can move read_head when the
+//   ring is full, therefore the consumer must call pop() with interrupts
+//   disabled.
+template<byte SIZE>
+class TimingRing {
+    static_assert(SIZE >= 2 && SIZE <= 128 && !(SIZE & (SIZE - 1)),
+            "TimingRing SIZE must be a power of 2, between 2 and 128");
+
+    private:
+        static const byte MASK = SIZE - 1;
+
+        volatile IH_timing_t timings[SIZE];
+        volatile byte write_head;
+        volatile byte read_head;
+        volatile bool overflowed;
+        byte policy;
+
+        volatile byte max_pending;
+        volatile uint16_t nb_dropped;
+        uint16_t nb_aborted_frames;
+
+    public:
+        TimingRing(byte arg_policy = RF433ANY_IH_OVERFLOW_POLICY):
+                write_head(0),
+                read_head(0),
+                overflowed(false),
+                policy(arg_policy) {
+            reset_stats();
+        }
+
+        void set_policy(byte arg_policy) { policy = arg_policy; }
+        byte get_policy() const { return policy; }
+
+            // To be called by the interrupt handler only
+        inline void push(byte r, uint16_t d) {
+            if (overflowed) {
+                if (nb_dropped != 0xffff)
+                    ++nb_dropped;
+                return;
+            }
+
+            byte next_write_head = (write_head + 1) & MASK;
+            if (next_write_head == read_head) {
+                if (nb_dropped != 0xffff)
+                    ++nb_dropped;
+                if (policy == RF433ANY_IH_DROP_NEWEST) {
+                    return;
+                } else if (policy == RF433ANY_IH_ABORT_FRAME) {
+                    overflowed = true;
+                    return;
+                }
+                read_head = (read_head + 1) & MASK;
+            }
+            write_head = next_write_head;
+            timings[write_head].r = r;
+            timings[write_head].d = d;
+
+            byte pending = (write_head - read_head) & MASK;
+            if (pending > max_pending)
+                max_pending = pending;
+        }
+
+            // To be called by the main loop only (see NOTE above about
+            // interrupts.)
+            // Returns true if a timing got copied into *pt, false if the ring
+            // is empty.
+        inline bool pop(IH_timing_t *pt) {
+            if (read_head == write_head)
+                return false;
+            pt->r = timings[read_head].r;
+            pt->d = timings[read_head].d;
+            read_head = (read_head + 1) & MASK;
+            return true;
+        }
+
+            // To be called by the main loop only, with interrupts disabled.
+            // Copies up to max pending timings into dst, returns the number of
+            // timings copied.
+        byte pop_all(IH_timing_t *dst, byte max) {
+            byte n = 0;
+            while (n < max && read_head != write_head) {
+                dst[n].r = timings[read_head].r;
+                dst[n].d = timings[read_head].d;
+                read_head = (read_head + 1) & MASK;
+                ++n;
+            }
+            return n;
+        }
+
+        byte get_pending() const { return (write_head - read_head) & MASK; }
+
+            // To be called by the main loop only, with interrupts disabled,
+            // the ring being empty.
+            // The last timing pushed is returned by pop() only once the next
+            // one got pushed. Copies it into *pt, and neutralizes it so that
+            // pop() returns (0, 0) instead (a timing Track ignores when
+            // waiting for a code).
+        void take_last(IH_timing_t *pt) {
+            pt->r = timings[write_head].r;
+            pt->d = timings[write_head].d;
+            timings[write_head].r = 0;
+            timings[write_head].d = 0;
+        }
+
+            // To be called by the main loop only, with interrupts disabled.
+            // Returns true if the ring overflowed under the
+            // RF433ANY_IH_ABORT_FRAME policy, in which case the ring is
+            // emptied and ready to record again.
+        bool take_overflow() {
+            if (!overflowed)
+                return false;
+            read_head = write_head;
+            overflowed = false;
+            if (nb_aborted_frames != 0xffff)
+                ++nb_aborted_frames;
+            return true;
+        }
+
+            // Interrupts must be disabled by caller
+        void get_stats(IH_stats_t *pstats) const {
+            pstats->max_pending = max_pending;
+            pstats->nb_dropped = nb_dropped;
+            pstats->nb_aborted_frames = nb_aborted_frames;
+        }
+
+        void reset_stats() {
+            max_pending = 0;
+            nb_dropped = 0;
+            nb_aborted_frames = 0;
+        }
+};
+
+    // Define RF433ANY_IH_SQUELCH to filter timings in the interrupt handler,
+    // before they are queued in the timings ring (see TimingSquelch).
+//#define RF433ANY_IH_SQUELCH
+#ifndef RF433ANY_IH_SQUELCH_MIN_D
+#define RF433ANY_IH_SQUELCH_MIN_D BAND_MIN_D
+#endif
+
+struct IH_squelch_stats_t {
+    uint32_t nb_forwarded;      // Timings queued in the ring
+    uint32_t nb_dropped;        // Timings merged or discarded
+};
+
+// Filter between the interrupt handler and the timings ring, so that noise
+// received while no code is being transmitted does not keep the main loop
+// busy.
+//   - A glitch (a timing shorter than min_d) is merged, along with the timing
+//     that follows it, into the timing that precedes it: the pulses A, G, C
+//     become one pulse A+G+C. To do so, a timing is held until the next one is
+//     known.
+//   - While the gate is closed, timings are discarded until one of them could
+//     be the initialization sequence of a code (same test as in
+//     Track::track_eat()). The gate is closed by Track::trk_reset().
+// min_d set to 0 disables the filter.
+class TimingSquelch {
+    private:
+        uint16_t min_d;
+        IH_timing_t held;
+        bool has_held;
+        bool merge_next;
+        volatile bool gate_open;
+
+        volatile uint32_t nb_forwarded;
+        volatile uint32_t nb_dropped;
+
+        static uint16_t add_sat(uint16_t a, uint16_t b) {
+            uint16_t s = a + b;
+            return s < a ? 0xffff : s;
+        }
+
+    public:
+        TimingSquelch(uint16_t arg_min_d = RF433ANY_IH_SQUELCH_MIN_D):
+                min_d(arg_min_d),
+                has_held(false),
+                merge_next(false),
+                gate_open(false) {
+            reset_stats();
+        }
+
+            // Interrupts must be disabled by caller
+        void set_min_d(uint16_t arg_min_d) {
+            min_d = arg_min_d;
+            has_held = false;
+            merge_next = false;
+            gate_open = false;
+        }
+        uint16_t get_min_d() const { return min_d; }
+
+            // To be called by the interrupt handler only.
+            // Returns true if a timing got copied into *pt, that is to be
+            // queued.
+        inline bool feed(byte r, uint16_t d, IH_timing_t *pt) {
+            if (!min_d) {
+                pt->r = r;
+                pt->d = d;
+                ++nb_forwarded;
+                return true;
+            }
+
+            if (merge_next || d < min_d) {
+                if (has_held) {
+                    held.d = add_sat(held.d, d);
+                        // If d is a glitch, the next timing is to be merged,
+                        // too.
+                    merge_next = !merge_next;
+                } else {
+                    merge_next = false;
+                }
+                ++nb_dropped;
+                return false;
+            }
+
+            bool ret = false;
+            if (has_held) {
+                if (!gate_open && held.r == 1
+                        && held.d >= TRACK_MIN_INITSEQ_DURATION) {
+                    gate_open = true;
+                }
+                if (gate_open) {
+                    pt->r = held.r;
+                    pt->d = held.d;
+                    ++nb_forwarded;
+                    ret = true;
+                } else {
+                    ++nb_dropped;
+                }
+            }
+            held.r = r;
+            held.d = d;
+            has_held = true;
+            return ret;
+        }
+
+        void close_gate() { gate_open = false; }
+
+            // Interrupts must be disabled by caller.
+            // Takes the timing held (it'd be forwarded by the next call to
+            // feed()). Returns true if it is to be queued.
+        bool take_held(IH_timing_t *pt) {
+            bool ret = has_held && gate_open;
+            if (ret) {
+                pt->r = held.r;
+                pt->d = held.d;
+            }
+            has_held = false;
+            merge_next = false;
+            return ret;
+        }
+
+            // Interrupts must be disabled by caller
+        void get_stats(IH_squelch_stats_t *pstats) const {
+            pstats->nb_forwarded = nb_forwarded;
+            pstats->nb_dropped = nb_dropped;
+        }
+
+        void reset_stats() {
+            nb_forwarded = 0;
+            nb_dropped = 0;
+        }
+};
+
+    // Storm guard (see Track::setopt_ih_storm_guard()), compiled in if
+    // RF433ANY_IH_STORM_GUARD is defined: a storm is detected when, out of the
+    // last 16 timings, RF433ANY_IH_STORM_MIN_SHORT at least are shorter than
+    // the duration matching the maximum edge rate.
+#ifndef RF433ANY_IH_STORM_MIN_SHORT
+#define RF433ANY_IH_STORM_MIN_SHORT 14
+#endif
+
+struct IH_storm_stats_t {
+    uint16_t nb_episodes;       // Storms detected
+    uint32_t total_ms;          // Time spent detached, of storms that ended
+    bool in_storm;              // Storm under way (timings discarded)
+};
+
+    // Callbacks are indexed by the hash of their code (BitVector::get_hash()),
+    // so that check_registered_callbacks() compares a decoded code with the
+    // callbacks of one bucket only, the ones having the same hash. The number
+    // of buckets doubles as callbacks get registered, from
+    // RF433ANY_CB_MIN_BUCKETS, so that there is one callback per bucket at
+    // most, on average.
+    // The encoding is not part of the bucket index, so that callbacks
+    // registered with RF433ANY_ID_ANY_ENCODING are in the same bucket as the
+    // ones of the same code with an encoding: callbacks are called in the
+    // order they got registered, as they are in a bucket.
+    // Callbacks registered with a mask (RF433ANY_MASKED_CALLBACKS being
+    // defined) are in the same table, indexed by the hash of the bits of their
+    // code that are in the mask. Each distinct mask is recorded once
+    // (callback_mask_t), and a decoded code is looked up once per mask of its
+    // length, then: the time to find the callbacks of a code does not depend
+    // on the number of callbacks, only on the number of distinct masks.
+    // The index is compiled in if RF433ANY_CALLBACK_INDEX is defined (it is,
+    // in the configuration block at the top of this file), otherwise a
+    // decoded code is compared with all callbacks, one after the other.
+#define RF433ANY_CB_MIN_BUCKETS 4
+
 struct callback_t {
     byte encoding;
     const BitVector *pcode;
@@ -618,34 +1535,138 @@ struct callback_t {
     uint32_t min_delay_between_two_calls;
     uint32_t last_trigger;
 
-    callback_t *next;
+#ifdef RF433ANY_MASKED_CALLBACKS
+    const BitVector *pmask;     // nullptr if no mask, otherwise the one of
+                                // the callback_mask_t equal to it
+#endif
+    callback_t *next;           // In the order of registration
+#ifdef RF433ANY_CALLBACK_INDEX
+    uint32_t hash;              // pcode->get_hash(pmask)
+    callback_t *next_in_bucket;
+#endif
+};
+
+#ifdef RF433ANY_MASKED_CALLBACKS
+struct callback_mask_t {
+    const BitVector *pmask;
+    callback_mask_t *next;
+};
+#endif
+
+    // Define RF433ANY_RECENT_CODES (a number of codes) to have Track remember
+    // the codes it decoded last, with the time they were seen last, whatever
+    // the calls to treset() in between. get_data() with RF433ANY_FD_NOT_RECENT
+    // (used by check_registered_callbacks()) then removes the codes seen less
+    // than a window ago (see setopt_recent_window()), so that a remote sending
+    // its code several times in a row, or as long as a button is pressed,
+    // triggers one call only. Each time a code is seen, its time is updated,
+    // even if it gets removed: the window counts from the last time.
+    // The codes of a reception get recorded once, by the first call to
+    // get_data() (whatever the filter), all copies included: further calls
+    // to get_data() on the same reception (for example, after do_events()
+    // called the callbacks) remove the same codes.
+    // Codes are told apart by their encoding and their hash
+    // (BitVector::get_hash()). When all entries are taken, the code seen
+    // least recently is forgotten.
+    // Default of setopt_recent_window()
+#define RF433ANY_RECENT_WINDOW_MS 500
+
+#ifdef RF433ANY_RECENT_CODES
+struct recent_code_t {
+    uint32_t hash;
+    uint32_t last_seen;     // millis()
+    byte encoding;          // RF433ANY_ID_RAW_INCONSISTENT if not in use
+    bool in_reception;      // Seen in the reception get_data() works on
+    bool was_recent;        // If in_reception: was recent when recorded
 };
+#endif
+
+    // Code book: a table of known codes, each with an action number, that
+    // costs no RAM per code (see register_codebook(), compiled in if
+    // RF433ANY_CODEBOOK is defined). On AVR, the table must be in flash
+    // (PROGMEM).
+    // IMPORTANT
+    //   Entries must be sorted by nb_bits, then by code, as done by
+    //   extras/codebook/codebook.py that generates the table from a list of
+    //   codes. Codes have 32 bits at most.
+struct codebook_entry_t {
+    uint32_t code;      // The last bit received is the least significant one
+    byte nb_bits;
+    byte encoding;      // RF433ANY_ID_ANY_ENCODING matches all encodings
+    uint16_t action;
+};
+
+void codebook_get_entry(const codebook_entry_t *table, uint16_t i,
+        codebook_entry_t *pentry);
+uint16_t codebook_find(const codebook_entry_t *table, uint16_t nb_entries,
+        byte nb_bits, uint32_t code);
 
-// NOTE - ABOUT STATIC MEMBER VARIABLES AND FUNCTIONS IN THE TRACK CLASS
-//   The class is designed so that one object is useful at a time. This comes
-//   from the fact that we attach interrupt handler to a static method (as is
-//   mandatory: an object method would not be possible, compiler would block
-//   because no way to populate 'this' pointer.)
-//   At last, the distinction between static and non-static members is a bit
-//   arbitrary.
-//   I decided that variables and functions _directly_ tied to interrupt handler
-//   are static, while all others are non-static.
+#if defined(ESP8266)
+#define RF433ANY_IRAM_ATTR IRAM_ATTR
+#else
+#define RF433ANY_IRAM_ATTR
+#endif
+
+// NOTE - ABOUT INTERRUPT HANDLERS AND MULTIPLE TRACK OBJECTS
+//   All the state tied to the interrupt handler (pin number, timings ring,
+//   ...) is owned by the Track object, so that multiple Track objects can
+//   record, each on its own pin.
+//   attachInterrupt() only accepts a plain function though (no way to
+//   populate 'this' pointer), therefore each Track object is bound to a
+//   'slot', a compile-time index that generates a distinct static trampoline
+//   (see TrackISR below).
+//   Track(pin) uses slot 0. To use more than one receiver, create the others
+//   with TrackSlot<N>, each with a distinct N (binding a slot already bound
+//   fails an assertion), for example:
+//     Track track0(2);
+//     TrackSlot<1> track1(3);
 typedef enum {TRK_WAIT, TRK_RECV, TRK_DATA} trk_t;
 class Track {
     private:
 #ifdef RF433ANY_DBG_TIMINGS
-        static uint16_t ih_dbg_timings[40];
-        static uint16_t ih_dbg_exec[40];
-        static unsigned int ih_dbg_pos;
-#endif
-        static byte pin_number;
-        static volatile IH_timing_t IH_timings[IH_SIZE];
-        static volatile unsigned char IH_write_head;
-        static volatile unsigned char IH_read_head;
-        static byte IH_max_pending_timings;
-        static bool IH_interrupt_handler_is_attached;
-        static volatile uint16_t IH_wait_free_last16;
-        static volatile short IH_wait_free_count_ok;
+        uint16_t ih_dbg_timings[40];
+        uint16_t ih_dbg_exec[40];
+        unsigned int ih_dbg_pos;
+#endif
+        byte pin_number;
+        void (*ih_func)();
+        void (*ih_wait_free_func)();
+        TimingRing<RF433ANY_IH_SIZE> IH_timings;
+#ifdef RF433ANY_IH_SQUELCH
+        TimingSquelch IH_squelch;
+#endif
+        unsigned long IH_last_t;
+            // Level of the pin after the last edge, as tracked by the
+            // interrupt handler of PinReaderParity.
+        volatile byte IH_level;
+        volatile bool IH_interrupt_handler_is_attached;
+        volatile uint16_t IH_wait_free_last16;
+        volatile short IH_wait_free_count_ok;
+
+#ifdef RF433ANY_IH_STORM_GUARD
+            // Storm guard, disabled if IH_storm_min_d is 0
+        uint16_t IH_storm_min_d;
+        uint16_t IH_storm_backoff_ms;
+        uint16_t IH_storm_last16;
+        byte IH_storm_count_short;
+        volatile bool IH_storm;
+        unsigned long IH_storm_start;
+        volatile uint16_t IH_storm_nb_episodes;
+        uint32_t IH_storm_total_ms;
+#endif
+
+#ifdef RF433ANY_IDLE_TIMEOUT
+            // Idle timeout, disabled if 0
+        unsigned long idle_timeout_us;
+#endif
+
+#ifdef RF433ANY_IH_BATCH
+            // Timings copied out of IH_timings by process_interrupt_timings(),
+            // not yet eaten.
+        IH_timing_t IH_block[RF433ANY_IH_SIZE];
+        byte IH_block_pos;
+        byte IH_block_len;
+#endif
 
         volatile trk_t trk;
         byte count;
@@ -659,22 +1680,172 @@ class Track {
         uint16_t last_low;
 
         RawCode rawcode;
+#if RF433ANY_RAWCODE_QUEUE > 0
+            // Codes received, waiting for treset()
+        RawCode rc_queue[RF433ANY_RAWCODE_QUEUE];
+        byte rc_head;
+        byte rc_count;
+#endif
+
+#ifdef RF433ANY_STREAM
+            // Streaming mode (see setopt_stream()), disabled if stream_func
+            // is null.
+        void (*stream_func)(const Decoder *pdec, void *data);
+        void *stream_data;
+        DecoderChain stream_chain;
+#endif
+
+#ifdef RF433ANY_ADAPTIVE_ORDER
+        DecoderHits decoder_hits;
+#endif
 
         callback_t *head;
+        callback_t *tail;
+#ifdef RF433ANY_CALLBACK_INDEX
+        uint16_t nb_callbacks;
+        callback_t **buckets;
+        uint16_t nb_buckets;
+#endif
+#ifdef RF433ANY_MASKED_CALLBACKS
+        callback_mask_t *masks;
+#endif
+#ifdef RF433ANY_CODEBOOK
+        const codebook_entry_t *codebook;
+        uint16_t codebook_nb_entries;
+        void (*codebook_func)(uint16_t action, void *data);
+        void *codebook_data;
+#endif
         bool opt_wait_free_433_before_calling_callbacks;
 
+#ifdef RF433ANY_RECENT_CODES
+        recent_code_t recent_codes[RF433ANY_RECENT_CODES];
+        uint16_t recent_window;
+        bool recent_recorded;
+        byte find_recent(uint32_t hash, byte id) const;
+        bool is_recent(const Decoder *pdec, uint32_t t) const;
+        void record_recent(const Decoder *pdec, uint32_t t);
+        void recent_new_reception();
+#endif
+
+        void ih_queue_timing(byte r, uint16_t d) {
+#ifdef RF433ANY_IH_STORM_GUARD
+            if (IH_storm_min_d && ih_storm_detect(d))
+                return;
+#endif
+#ifdef RF433ANY_IH_SQUELCH
+            IH_timing_t timing;
+            if (IH_squelch.feed(r, d, &timing))
+                IH_timings.push(timing.r, timing.d);
+#else
+            IH_timings.push(r, d);
+#endif
+        }
+#ifdef RF433ANY_IH_SQUELCH
+        void ih_squelch_close_gate();
+#endif
+#ifdef RF433ANY_IH_STORM_GUARD
+        bool ih_storm_detect(uint16_t d);
+        bool ih_storm_is_over();
+#endif
+            // True if no timing copied out of the ring is waiting to be eaten
+        bool ih_block_is_empty() const {
+#ifdef RF433ANY_IH_BATCH
+            return IH_block_pos == IH_block_len;
+#else
+            return true;
+#endif
+        }
+        DecoderHits *get_phits() {
+#ifdef RF433ANY_ADAPTIVE_ORDER
+            return &decoder_hits;
+#else
+            return nullptr;
+#endif
+        }
+
+        void trk_reset();
+        void trk_terminate();
+#if RF433ANY_RAWCODE_QUEUE > 0
+        bool rawcode_enqueue();
+#endif
+#ifdef RF433ANY_STREAM
+        void stream_section(const Section *psec);
+        void stream_deliver(Decoder *pdec);
+        void stream_flush();
+#endif
+        RawCode *get_prawcode() {
+#if RF433ANY_RAWCODE_QUEUE > 0
+            if (rc_count)
+                return &rc_queue[rc_head];
+#endif
+            return &rawcode;
+        }
+
         void reset_border_mgmt();
+        void track_eat_wait(byte r, uint16_t d);
+        bool track_eat_recv(byte& r, uint16_t d);
+        void eat_timing(const IH_timing_t& timing);
         Decoder* get_data_core(byte convention);
 
-        callback_t* get_tail(const callback_t* h);
+        callback_t *new_callback(byte encoding, const BitVector *pcode,
+                void *data, void (*func)(void *data),
+                uint32_t min_delay_between_two_calls);
+        void add_callback(callback_t *pc);
+#ifdef RF433ANY_CALLBACK_INDEX
+        void index_callback(callback_t *pc);
+        void build_callback_index(uint16_t arg_nb_buckets);
+#endif
+#ifdef RF433ANY_MASKED_CALLBACKS
+        const BitVector *record_mask(const BitVector *pmask);
+#endif
+        void call_callbacks(const Decoder *pdec, const BitVector *pmask,
+                uint32_t t0, bool *pflag_call_wait_free_433);
+#ifdef RF433ANY_CODEBOOK
+        void call_codebook(const Decoder *pdec,
+                bool *pflag_call_wait_free_433);
+#endif
+        void majority_vote(Decoder *pdec0);
+
+    protected:
+        Track(int arg_pin_number, byte mood, void (*arg_ih_func)(),
+                void (*arg_ih_wait_free_func)());
+        void bind_slot(Track **pslot);
 
     public:
         Track(int arg_pin_number, byte mood = DEFAULT_RAIL_MOOD);
 
-        static void ih_handle_interrupt();
-        static void ih_handle_interrupt_wait_free();
-        static byte ih_get_max_pending_timings() {
-            return IH_max_pending_timings;
+        void ih_handle_interrupt();
+        void ih_handle_interrupt_wait_free();
+        byte ih_get_max_pending_timings();
+        void ih_get_stats(IH_stats_t *pstats);
+        void ih_reset_stats();
+        void setopt_ih_overflow_policy(byte policy);
+        void ih_push_timing(byte r, uint16_t d);
+#ifdef RF433ANY_IH_STORM_GUARD
+        void setopt_ih_storm_guard(uint32_t max_edges_per_second,
+                uint16_t backoff_ms);
+        void ih_get_storm_stats(IH_storm_stats_t *pstats);
+#endif
+#ifdef RF433ANY_IH_SQUELCH
+        void setopt_ih_squelch(uint16_t min_d);
+        void ih_get_squelch_stats(IH_squelch_stats_t *pstats);
+#endif
+
+            // Record an edge that occurred at time t (as returned by
+            // micros()), the pin being at level r after the edge.
+            // Defined here so that it gets inlined in the interrupt handlers
+            // bound at compile time (see TrackFast).
+        void ih_record_edge(byte r, unsigned long t) {
+            unsigned long d = t - IH_last_t;
+            IH_last_t = t;
+                // Same as 'if (d > RF433ANY_MAX_DURATION) ...', but looks at
+                // the high word only: cheaper on 8-bit MCUs.
+            ih_queue_timing(r,
+                    (d >> 16) ? RF433ANY_MAX_DURATION : (uint16_t)d);
+        }
+        byte ih_toggle_level() {
+            IH_level ^= 1;
+            return IH_level;
         }
 
         void treset();
@@ -686,26 +1857,210 @@ class Track {
         void dbg_timings() const;
 #endif
 
-        trk_t get_trk() const { return trk; }
+            // TRK_DATA if a code is available for get_data(), otherwise the
+            // state of reception.
+        trk_t get_trk() const {
+#if RF433ANY_RAWCODE_QUEUE > 0
+            if (rc_count)
+                return TRK_DATA;
+#endif
+            return trk;
+        }
+        bool is_recording() const { return IH_interrupt_handler_is_attached; }
 
         void force_stop_recv();
+#ifdef RF433ANY_IDLE_TIMEOUT
+        void setopt_idle_timeout(uint16_t timeout_ms);
+        bool check_idle(unsigned long t);
+#endif
+#ifdef RF433ANY_STREAM
+        void setopt_stream(void (*func)(const Decoder *pdec, void *data),
+                void *data);
+#endif
 
         void activate_recording();
         void deactivate_recording();
         bool process_interrupt_timing();
+        bool process_interrupt_timings();
         bool do_events();
 
         void wait_free_433();
 
         Decoder* get_data(uint16_t filter, byte convention = RF433ANY_CONV0);
+#ifdef RF433ANY_ADAPTIVE_ORDER
+            // Number of sections decoded with the decoder of id id (see
+            // DecoderHits)
+        byte get_decoder_hits(byte id) const {
+            return (id <= RF433ANY_ID_END ? decoder_hits.hits[id] : 0);
+        }
+        void reset_decoder_hits() { decoder_hits.reset(); }
+#endif
 
         void setopt_wait_free_433_before_calling_callbacks(const bool val);
+#ifdef RF433ANY_RECENT_CODES
+            // 0 means RF433ANY_FD_NOT_RECENT removes nothing
+        void setopt_recent_window(uint16_t ms) { recent_window = ms; }
+        void reset_recent_codes();
+#endif
         void register_callback(byte encoding, const BitVector *pcode,
                 void *data, void (*func)(void *data),
                 uint32_t min_delay_between_two_calls);
+#ifdef RF433ANY_MASKED_CALLBACKS
+        void register_callback(byte encoding, const BitVector *pcode,
+                const BitVector *pmask, void *data, void (*func)(void *data),
+                uint32_t min_delay_between_two_calls);
+#endif
+#ifdef RF433ANY_CODEBOOK
+        void register_codebook(const codebook_entry_t *table,
+                uint16_t nb_entries, void (*func)(uint16_t action, void *data),
+                void *data);
+#endif
         void check_registered_callbacks();
 };
 
+// Static trampolines to the interrupt handlers of the Track object bound to
+// slot SLOT.
+template<byte SLOT>
+struct TrackISR {
+    static Track *ptrack;
+
+    static RF433ANY_IRAM_ATTR void ih_handle_interrupt() {
+        ptrack->ih_handle_interrupt();
+    }
+    static RF433ANY_IRAM_ATTR void ih_handle_interrupt_wait_free() {
+        ptrack->ih_handle_interrupt_wait_free();
+    }
+};
+
+template<byte SLOT>
+Track *TrackISR<SLOT>::ptrack = nullptr;
+
+template<byte SLOT>
+class TrackSlot: public Track {
+    public:
+        TrackSlot(int arg_pin_number, byte mood = DEFAULT_RAIL_MOOD):
+                Track(arg_pin_number, mood,
+                      &TrackISR<SLOT>::ih_handle_interrupt,
+                      &TrackISR<SLOT>::ih_handle_interrupt_wait_free) {
+            bind_slot(&TrackISR<SLOT>::ptrack);
+        }
+};
+
+// * *********** **************************************************************
+// * Pin readers **************************************************************
+// * *********** **************************************************************
+
+// NOTE - ABOUT PIN READERS
+//   A pin reader tells the level of the pin after an edge, for the interrupt
+//   handler of TrackFast. It has a compile-time pin number, so that the read
+//   can boil down to a few instructions.
+//   A pin reader is a class with:
+//     static const byte pin;                   // Pin number
+//     static void init();                      // Called once by TrackFast
+//     static byte read(Track *ptrack);         // Returns 0 or 1
+//   Any class with this interface can be used, for example to mock the port
+//   register when running the library on a computer.
+
+    // Reference reader, same as Track::ih_handle_interrupt().
+template<byte PIN>
+struct PinReaderDigital {
+    static const byte pin = PIN;
+    static void init() { }
+    static byte read(Track *) { return digitalRead(PIN) == HIGH ? 1 : 0; }
+};
+
+    // Reads the port input register.
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+    // Arduino UNO, Nano, ...: the register and the bit mask are resolved at
+    // compile time, the read is one 'in' instruction.
+template<byte PIN>
+struct PinReaderPort {
+    static_assert(PIN < 20, "PinReaderPort: invalid pin number");
+    static const byte pin = PIN;
+    static void init() { }
+    static byte read(Track *) {
+        if (PIN < 8)
+            return PIND & _BV(PIN) ? 1 : 0;
+        else if (PIN < 14)
+            return PINB & _BV(PIN - 8) ? 1 : 0;
+        else
+            return PINC & _BV(PIN - 14) ? 1 : 0;
+    }
+};
+#elif defined(__AVR__)
+    // Other AVRs: the register and the bit mask are looked up once.
+template<byte PIN>
+struct PinReaderPort {
+    static const byte pin = PIN;
+    static volatile uint8_t *reg;
+    static uint8_t mask;
+    static void init() {
+        reg = portInputRegister(digitalPinToPort(PIN));
+        mask = digitalPinToBitMask(PIN);
+    }
+    static byte read(Track *) { return *reg & mask ? 1 : 0; }
+};
+template<byte PIN>
+volatile uint8_t *PinReaderPort<PIN>::reg = nullptr;
+template<byte PIN>
+uint8_t PinReaderPort<PIN>::mask = 0;
+#else
+    // No port register knowledge on this architecture, fall back to
+    // digitalRead().
+template<byte PIN>
+struct PinReaderPort: public PinReaderDigital<PIN> { };
+#endif
+
+    // Does not read the pin: as the interrupt handler is called on each
+    // change, the level is toggled at each edge. The level is read when the
+    // handler gets attached (Track::activate_recording()).
+    // IMPORTANT
+    //   If an edge is missed (two edges too close for the interrupt to
+    //   trigger twice), the levels get inverted until the handler is
+    //   attached again (normally, once the next code is received).
+template<byte PIN>
+struct PinReaderParity {
+    static const byte pin = PIN;
+    static void init() { }
+    static byte read(Track *ptrack) { return ptrack->ih_toggle_level(); }
+};
+
+// * ********* ****************************************************************
+// * TrackFast ****************************************************************
+// * ********* ****************************************************************
+
+template<class PINREADER, byte SLOT>
+struct TrackFastISR {
+    static Track *ptrack;
+
+    static RF433ANY_IRAM_ATTR void ih_handle_interrupt() {
+        const unsigned long t = micros();
+        Track *p = ptrack;
+        p->ih_record_edge(PINREADER::read(p), t);
+    }
+};
+
+template<class PINREADER, byte SLOT>
+Track *TrackFastISR<PINREADER, SLOT>::ptrack = nullptr;
+
+// Track whose interrupt handler is bound to the pin at compile time, and reads
+// the pin with PINREADER. Uses slot SLOT, like TrackSlot<SLOT>: along with a
+// plain Track object, that uses slot 0, give another slot.
+// Example:
+//   TrackFast<PinReaderPort<2>> track;
+template<class PINREADER, byte SLOT = 0>
+class TrackFast: public Track {
+    public:
+        TrackFast(byte mood = DEFAULT_RAIL_MOOD):
+                Track(PINREADER::pin, mood,
+                      &TrackFastISR<PINREADER, SLOT>::ih_handle_interrupt,
+                      &TrackISR<SLOT>::ih_handle_interrupt_wait_free) {
+            bind_slot(&TrackISR<SLOT>::ptrack);
+            TrackFastISR<PINREADER, SLOT>::ptrack = this;
+            PINREADER::init();
+        }
+};
+
 #endif // _RF433ANY_H
 
 // vim: ts=4:sw=4:tw=80:et
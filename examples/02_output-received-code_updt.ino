@@ -44,7 +44,7 @@ char* my_BitVector_to_str(const BitVector *bv) {
     if (!bv->get_nb_bits())
         return nullptr;
 
-    byte nb_bytes = bv->get_nb_bytes();
+    uint16_t nb_bytes = bv->get_nb_bytes();
 
     char *ret = (char*)malloc(nb_bytes * 3);
     char tmp[3];
@@ -0,0 +1,1660 @@
+// bench.ino
+
+// Benchmarks of RF433any library
+
+/*
+  Copyright 2021 Sébastien Millet
+
+  `RF433any' is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  `RF433any' is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program. If not, see
+  <https://www.gnu.org/licenses>.
+*/
+
+//
+// Reads timings on the serial line, in the same format as the test plan
+// (lines of "low,high", terminated by a line containing a single '.'), then
+// runs each benchmark against these timings and prints the results.
+//
+// See bench.sh to run it against test plan files.
+//
+// The timings are fed straight into the library (no actual radio signal is
+// needed), the interrupt handler side is simulated.
+//
+
+#define PIN_RFINPUT  2
+
+#include "RF433any.h"
+#include "RF433Serial.h"
+#include <Arduino.h>
+
+#define MAX_TIMINGS 280
+
+RF433SerialLine sl_bench;
+char line[RF433SERIAL_LINE_BUF_LEN];
+
+uint16_t timings[MAX_TIMINGS];
+uint16_t nb_timings;
+    // If the input contains a line "-", the timings after it (a second code)
+    // go at the end of timings[], from index nb_timings to nb_timings_all - 1.
+    // Only the "Back-to-back codes" benchmark uses them.
+uint16_t nb_timings_all;
+
+char serial_printf_buffer[100];
+void serial_printf(const char* msg, ...)
+     __attribute__((format(printf, 1, 2)));
+
+    // NOTE
+    //   Assume Serial has been initialized (Serial.begin(...))
+void serial_printf(const char* msg, ...) {
+    va_list args;
+
+    va_start(args, msg);
+
+    vsnprintf(serial_printf_buffer, sizeof(serial_printf_buffer), msg, args);
+    va_end(args);
+    Serial.print(serial_printf_buffer);
+}
+
+void setup() {
+    pinMode(PIN_RFINPUT, INPUT);
+    Serial.begin(115200);
+}
+
+Track track(PIN_RFINPUT);
+
+    // Track fed by track_eat() only, that does not take a slot (see TrackSlot
+    // in RF433any.h): its recording must never be activated.
+class TrackReplay: public Track {
+    public:
+        TrackReplay():
+                Track(PIN_RFINPUT, DEFAULT_RAIL_MOOD, nullptr, nullptr) { }
+};
+
+void read_timings_from_usb() {
+    bool second_code = false;
+    nb_timings = 0;
+    nb_timings_all = 0;
+    line[0] = '\0';
+    for (   ;
+            strcmp(line, ".");
+            sl_bench.get_line_blocking(line, sizeof(line))
+        ) {
+
+        if (!strlen(line))
+            continue;
+
+        if (!strcmp(line, "-")) {
+            second_code = true;
+            continue;
+        }
+
+        char *p = line;
+        while (*p != ',' && *p != '\0')
+            ++p;
+        if (*p != ',' || nb_timings_all + 2 > MAX_TIMINGS)
+            continue;
+
+        *p = '\0';
+        timings[nb_timings_all++] = atoi(line);
+        timings[nb_timings_all++] = atoi(p + 1);
+        if (!second_code)
+            nb_timings = nb_timings_all;
+    }
+}
+
+    // Pseudo-random generator, so that results are reproducible from one run
+    // to the next.
+uint32_t lcg_state;
+void lcg_seed(uint32_t seed) { lcg_state = seed; }
+uint16_t lcg_rand() {
+    lcg_state = lcg_state * 1103515245UL + 12345UL;
+    return (uint16_t)(lcg_state >> 16);
+}
+
+    // When built with RF433ANY_RAWCODE_QUEUE, treset() discards one code
+    // only.
+void track_reset(Track *ptrack) {
+    while (ptrack->get_trk() == TRK_DATA)
+        ptrack->treset();
+    ptrack->treset();
+}
+
+void track_stop(Track *ptrack) {
+    if (ptrack->get_trk() == TRK_RECV) {
+        ptrack->track_eat(0, 0);
+        ptrack->track_eat(1, 0);
+    }
+}
+
+    // Returns true if the two decoder chains carry the same codes.
+bool same_data(const Decoder *pdec1, const Decoder *pdec2) {
+    while (pdec1 && pdec2) {
+        if (pdec1->get_id() != pdec2->get_id())
+            return false;
+        const BitVector *p1 = pdec1->get_pdata();
+        const BitVector *p2 = pdec2->get_pdata();
+        if ((!p1) != (!p2))
+            return false;
+        if (p1 && p1->cmp(p2))
+            return false;
+        pdec1 = pdec1->get_next();
+        pdec2 = pdec2->get_next();
+    }
+    return !pdec1 && !pdec2;
+}
+
+Decoder *decode_reference(uint16_t first, uint16_t last) {
+    track_reset(&track);
+    for (uint16_t i = first; i < last; ++i)
+        track.track_eat((i - first) & 1, timings[i]);
+    track_stop(&track);
+    Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+    track_reset(&track);
+    return pdec;
+}
+
+
+// * *********** **************************************************************
+// * Ring stress **************************************************************
+// * *********** **************************************************************
+
+#define RING_NB_FRAMES      100
+#define RING_STALL_ONE_IN    16 // Each edge has 1/16 chance to start a stall
+#define RING_STALL_MAX        8 // A stall lasts 1 to 8 edges
+
+template<byte SIZE>
+void ring_drain(TimingRing<SIZE> *pring) {
+    if (pring->take_overflow())
+        track_reset(&track);
+    IH_timing_t t;
+    while (pring->pop(&t))
+        track.track_eat(t.r, t.d);
+}
+
+template<byte SIZE>
+void bench_ring_size(const Decoder *pref, byte policy,
+        const char *policy_name) {
+    TimingRing<SIZE> ring(policy);
+    uint16_t survived = 0;
+
+    lcg_seed(SIZE);
+    for (uint16_t frame = 0; frame < RING_NB_FRAMES; ++frame) {
+        track_reset(&track);
+        byte stall = 0;
+        for (uint16_t i = 0; i < nb_timings; ++i) {
+            ring.push(i & 1, timings[i]);
+            if (stall) {
+                --stall;
+            } else if (!(lcg_rand() % RING_STALL_ONE_IN)) {
+                stall = 1 + lcg_rand() % RING_STALL_MAX;
+            } else {
+                ring_drain(&ring);
+            }
+        }
+            // Same as the one-slot latency seen on hardware: the last timing
+            // is eaten when the next edge occurs.
+        ring.push(0, 0);
+        ring_drain(&ring);
+        track_stop(&track);
+
+        Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+        if (same_data(pref, pdec))
+            ++survived;
+        delete pdec;
+    }
+
+    IH_stats_t stats;
+    ring.get_stats(&stats);
+    serial_printf("ring %3d  %-11s  survived %3u/%u  dropped %5u  "
+            "aborted %3u  max pending %3u\n", SIZE, policy_name, survived,
+            RING_NB_FRAMES, stats.nb_dropped, stats.nb_aborted_frames,
+            stats.max_pending);
+}
+
+const char *policy_names[] = {
+    "drop-oldest",
+    "drop-newest",
+    "abort-frame"
+};
+
+void bench_ring(const Decoder *pref) {
+    for (byte p = 0; p < 3; ++p) {
+        bench_ring_size<4>(pref, p, policy_names[p]);
+        bench_ring_size<8>(pref, p, policy_names[p]);
+        bench_ring_size<16>(pref, p, policy_names[p]);
+        bench_ring_size<32>(pref, p, policy_names[p]);
+    }
+}
+
+// * ************* ************************************************************
+// * Batched drain ************************************************************
+// * ************* ************************************************************
+
+// Without RF433ANY_IH_BATCH defined in RF433any.h, process_interrupt_timings()
+// takes the timings one at a time, as process_interrupt_timing() does.
+
+#define DRAIN_NB_FRAMES 100
+    // Number of timings the interrupt handler records between two calls to
+    // do_events(), at most the ring capacity.
+#define DRAIN_BURST     (RF433ANY_IH_SIZE - 1)
+
+void track_drain() {
+    while (track.process_interrupt_timings())
+        ;
+}
+
+void bench_drain(const Decoder *pref) {
+    const char *names[] = { "per-item", "batch" };
+
+    for (byte batch = 0; batch < 2; ++batch) {
+        unsigned long nb_calls = 0;
+        unsigned long duration = 0;
+        uint16_t nb_ok = 0;
+
+        track_drain();
+        for (uint16_t frame = 0; frame < DRAIN_NB_FRAMES; ++frame) {
+            track_reset(&track);
+            uint16_t i = 0;
+            while (i <= nb_timings) {
+                for (byte b = 0; b < DRAIN_BURST && i <= nb_timings; ++b) {
+                        // The extra timing at the end is the edge that flushes
+                        // the ring one-slot latency.
+                    track.ih_push_timing(i & 1,
+                            i < nb_timings ? timings[i] : 0);
+                    ++i;
+                }
+                unsigned long t0 = micros();
+                if (batch) {
+                    while (track.process_interrupt_timings())
+                        ++nb_calls;
+                } else {
+                    while (track.process_interrupt_timing())
+                        ++nb_calls;
+                }
+                ++nb_calls;
+                duration += micros() - t0;
+            }
+            track_stop(&track);
+
+            Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+            if (same_data(pref, pdec))
+                ++nb_ok;
+            delete pdec;
+        }
+
+        unsigned long nb = (unsigned long)DRAIN_NB_FRAMES * (nb_timings + 1);
+        serial_printf("drain %-8s  ok %3u/%u  calls/timing %lu.%02lu  "
+                "ns/timing %lu", names[batch], nb_ok, DRAIN_NB_FRAMES,
+                nb_calls / nb, (nb_calls * 100 / nb) % 100,
+                (unsigned long)((duration * 1000.0) / nb));
+#ifdef F_CPU
+        serial_printf("  cycles/timing %lu",
+                (unsigned long)((duration * (F_CPU / 1000000.0)) / nb));
+#endif
+        serial_printf("\n");
+    }
+}
+
+// * ******** *****************************************************************
+// * ISR cost *****************************************************************
+// * ******** *****************************************************************
+
+#define ISR_NB_CALLS 3000
+
+    // Mocked port register: the level of the pin is set by the benchmark
+    // instead of the radio receiver.
+volatile byte mock_port_reg;
+
+struct PinReaderMock {
+    static const byte pin = PIN_RFINPUT;
+    static void init() { }
+    static byte read(Track *) { return mock_port_reg & 1; }
+};
+
+    // Slot 0 is used by 'track'.
+TrackFast<PinReaderMock, 1> track_mock;
+TrackFast<PinReaderParity<PIN_RFINPUT>, 2> track_parity;
+#ifdef __AVR__
+TrackFast<PinReaderPort<PIN_RFINPUT>, 3> track_port;
+#endif
+
+void isr_micros_only() {
+    volatile unsigned long t = micros();
+    (void)t;
+}
+
+    // Feeds the timings through ih_record_edge(), the levels being read by
+    // PINREADER from the mocked register, and checks the decoded data are
+    // the same as with track_eat().
+template<class PINREADER>
+bool check_reader(const Decoder *pref, Track *ptrack) {
+#ifdef RF433ANY_IH_SQUELCH
+    ptrack->setopt_ih_squelch(0);
+#endif
+    track_reset(ptrack);
+    while (ptrack->process_interrupt_timings())
+        ;
+    track_reset(ptrack);
+
+        // The edge before the first timing. It sets the time origin, and the
+        // level of PinReaderParity (it is then 1, as first timing is a low
+        // one).
+    mock_port_reg = 1;
+    if (!ptrack->ih_toggle_level())
+        ptrack->ih_toggle_level();
+    unsigned long t = 0;
+    ptrack->ih_record_edge(1, t);
+
+    for (uint16_t i = 0; i <= nb_timings; ++i) {
+        mock_port_reg = i & 1;
+        t += (i < nb_timings ? timings[i] : 0);
+        ptrack->ih_record_edge(PINREADER::read(ptrack), t);
+        while (ptrack->process_interrupt_timings())
+            ;
+    }
+    track_stop(ptrack);
+
+    Decoder *pdec = ptrack->get_data(RF433ANY_FD_DECODED);
+    bool ok = same_data(pref, pdec);
+    delete pdec;
+    return ok;
+}
+
+    // Calls the interrupt handler ISR_NB_CALLS times in a row. The ring gets
+    // full quickly, so most calls go through the 'drop oldest' path of
+    // TimingRing::push(), this is the same for all handlers measured.
+void bench_isr_cost(const char *name, Track *ptrack, void (*isr)(),
+        bool ok) {
+    ptrack->setopt_ih_overflow_policy(RF433ANY_IH_DROP_OLDEST);
+    mock_port_reg = 0;
+
+    unsigned long t0 = micros();
+    for (uint16_t n = 0; n < ISR_NB_CALLS; ++n)
+        isr();
+    unsigned long duration = micros() - t0;
+
+    while (ptrack->process_interrupt_timings())
+        ;
+    track_reset(ptrack);
+    ptrack->ih_reset_stats();
+
+    serial_printf("isr %-14s  %s  ns/call %lu", name, ok ? "ok" : "KO",
+            (unsigned long)((duration * 1000.0) / ISR_NB_CALLS));
+#ifdef F_CPU
+    serial_printf("  cycles/call %lu",
+            (unsigned long)((duration * (F_CPU / 1000000.0)) / ISR_NB_CALLS));
+#endif
+    serial_printf("\n");
+}
+
+void bench_isr(const Decoder *pref) {
+    bench_isr_cost("micros() only", &track, &isr_micros_only, true);
+    bench_isr_cost("digitalRead", &track, &TrackISR<0>::ih_handle_interrupt,
+            true);
+    bench_isr_cost("mock register", &track_mock,
+            &TrackFastISR<PinReaderMock, 1>::ih_handle_interrupt,
+            check_reader<PinReaderMock>(pref, &track_mock));
+    bench_isr_cost("edge parity", &track_parity,
+            &TrackFastISR<PinReaderParity<PIN_RFINPUT>, 2>::ih_handle_interrupt,
+            check_reader<PinReaderParity<PIN_RFINPUT>>(pref, &track_parity));
+#ifdef __AVR__
+    bench_isr_cost("port register", &track_port,
+            &TrackFastISR<PinReaderPort<PIN_RFINPUT>, 3>::ih_handle_interrupt,
+            true);
+#endif
+}
+
+// * ******* ******************************************************************
+// * Squelch ******************************************************************
+// * ******* ******************************************************************
+
+// Requires RF433ANY_IH_SQUELCH to be defined in RF433any.h.
+//
+// Run against the input timings (that can be a capture of noise only, in which
+// case the data decoded is not checked), then against random noise.
+
+#define SQUELCH_NB_PASSES   20
+#define SQUELCH_NOISE_LEN 2000
+
+    // Random noise: durations spread from a few us to a few ms, more short
+    // ones than long ones.
+uint16_t noise_timing() {
+    return 1 + lcg_rand() % (1u << (3 + lcg_rand() % 10));
+}
+
+#ifdef RF433ANY_IH_SQUELCH
+void bench_squelch_run(const Decoder *pref, bool noise, uint16_t min_d) {
+    uint16_t nb = (noise ? SQUELCH_NOISE_LEN : nb_timings);
+    uint16_t nb_ok = 0;
+    unsigned long duration = 0;
+
+    track.setopt_ih_squelch(min_d);
+    track.ih_reset_stats();
+    lcg_seed(1);
+    for (uint16_t pass = 0; pass < SQUELCH_NB_PASSES; ++pass) {
+        track_reset(&track);
+            // The two last timings flush the timing held by the squelch, and
+            // the one-slot latency of the ring, as in simulation mode.
+        for (uint16_t i = 0; i < nb + 2; ++i) {
+            uint16_t d;
+            if (i >= nb)
+                d = 100;
+            else
+                d = (noise ? noise_timing() : timings[i]);
+            track.ih_push_timing(i & 1, d);
+            if ((i % DRAIN_BURST) == DRAIN_BURST - 1 || i == nb + 1) {
+                unsigned long t0 = micros();
+                track.do_events();
+                duration += micros() - t0;
+                if (track.get_trk() == TRK_DATA && noise)
+                    track_reset(&track);
+            }
+        }
+        track_stop(&track);
+
+        if (pref) {
+            Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+            if (same_data(pref, pdec))
+                ++nb_ok;
+            delete pdec;
+        }
+    }
+
+    IH_squelch_stats_t stats;
+    track.ih_get_squelch_stats(&stats);
+    unsigned long nb_edges = (unsigned long)SQUELCH_NB_PASSES * (nb + 2);
+    serial_printf("squelch %-5s min_d %3u  ", noise ? "noise" : "input",
+            min_d);
+    if (pref)
+        serial_printf("ok %3u/%u  ", nb_ok, SQUELCH_NB_PASSES);
+    serial_printf("forwarded %5lu  dropped %5lu  main loop ns/edge %lu\n",
+            (unsigned long)stats.nb_forwarded,
+            (unsigned long)stats.nb_dropped,
+            (unsigned long)((duration * 1000.0) / nb_edges));
+}
+#endif
+
+void bench_squelch(const Decoder *pref) {
+#ifdef RF433ANY_IH_SQUELCH
+    bench_squelch_run(pref, false, 0);
+    bench_squelch_run(pref, false, RF433ANY_IH_SQUELCH_MIN_D);
+    bench_squelch_run(nullptr, true, 0);
+    bench_squelch_run(nullptr, true, RF433ANY_IH_SQUELCH_MIN_D);
+    track_reset(&track);
+        // The other benchmarks measure the library without the squelch.
+    track.setopt_ih_squelch(0);
+    track.ih_reset_stats();
+#else
+    (void)pref;
+    serial_printf("squelch: RF433ANY_IH_SQUELCH not defined, skipped\n");
+#endif
+}
+
+// * *********** **************************************************************
+// * Storm guard **************************************************************
+// * *********** **************************************************************
+
+// Requires RF433ANY_IH_STORM_GUARD to be defined in RF433any.h.
+
+#define STORM_MAX_RATE   10000 // Edges per second
+#define STORM_BACKOFF_MS    50
+#define STORM_NB_EDGES    5000
+
+#ifdef RF433ANY_IH_STORM_GUARD
+    // Interference of a nearby device: timings of 5 to 84 us, that is, 12000 to
+    // 200000 edges per second.
+uint16_t storm_timing() {
+    return 5 + lcg_rand() % 80;
+}
+
+    // Feeds the input timings, returns true if the data decoded are the same
+    // as pref.
+bool storm_feed_code(const Decoder *pref) {
+    track_reset(&track);
+    for (uint16_t i = 0; i < nb_timings + 2; ++i) {
+        track.ih_push_timing(i & 1, i < nb_timings ? timings[i] : 100);
+        if ((i % DRAIN_BURST) == DRAIN_BURST - 1 || i == nb_timings + 1)
+            track.do_events();
+    }
+    track_stop(&track);
+
+    Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+    bool ok = same_data(pref, pdec);
+    delete pdec;
+    track_reset(&track);
+    return ok;
+}
+
+    // On hardware, the edges received once the storm is detected get
+    // discarded, until do_events() detaches the interrupt handler.
+void storm_feed_noise(uint16_t *pnb_edges_to_detect) {
+    IH_storm_stats_t stats;
+
+    lcg_seed(2);
+    *pnb_edges_to_detect = 0;
+    for (uint16_t i = 0; i < STORM_NB_EDGES; ++i) {
+        track.ih_get_storm_stats(&stats);
+        if (!stats.in_storm)
+            ++*pnb_edges_to_detect;
+        track.ih_push_timing(i & 1, storm_timing());
+        if ((i % DRAIN_BURST) == DRAIN_BURST - 1) {
+            if (track.do_events())
+                track_reset(&track);
+        }
+    }
+}
+#endif
+
+void bench_storm(const Decoder *pref) {
+#ifdef RF433ANY_IH_STORM_GUARD
+    IH_storm_stats_t stats;
+    uint16_t nb_edges_to_detect;
+
+    track_reset(&track);
+    for (byte on = 0; on < 2; ++on) {
+        track.setopt_ih_storm_guard(on ? STORM_MAX_RATE : 0, STORM_BACKOFF_MS);
+        track.ih_reset_stats();
+
+        bool ok_before = storm_feed_code(pref);
+        storm_feed_noise(&nb_edges_to_detect);
+        track.ih_get_storm_stats(&stats);
+        bool in_storm = stats.in_storm;
+
+            // do_events() must not record again before the backoff delay
+        track.do_events();
+        track.ih_get_storm_stats(&stats);
+        bool early_rearm = in_storm && !stats.in_storm;
+        unsigned long t0 = millis();
+        while (millis() - t0 <= STORM_BACKOFF_MS)
+            ;
+        track.do_events();
+        track.ih_get_storm_stats(&stats);
+
+        bool ok_after = storm_feed_code(pref);
+
+        serial_printf("storm guard %-3s  code before %s  after %s  "
+                "episodes %u%s%s\n", on ? "on" : "off",
+                ok_before ? "ok" : "KO", ok_after ? "ok" : "KO",
+                stats.nb_episodes, early_rearm ? "  EARLY RE-ARM" : "",
+                stats.in_storm ? "  NOT RE-ARMED" : "");
+        serial_printf("    edges to detect %u  ignored %u/%u\n",
+                in_storm ? nb_edges_to_detect : 0,
+                in_storm ? STORM_NB_EDGES - nb_edges_to_detect : 0,
+                STORM_NB_EDGES);
+    }
+    track.setopt_ih_storm_guard(0, 0);
+    track.ih_reset_stats();
+#else
+    (void)pref;
+    serial_printf("storm: RF433ANY_IH_STORM_GUARD not defined, skipped\n");
+#endif
+}
+
+// * ******************* ******************************************************
+// * Track state machine ******************************************************
+// * ******************* ******************************************************
+
+    // Time spent by track_eat() per timing, averaged over the input timings
+    // eaten TRACK_NB_PASSES times, and the longest call.
+    // Build with and without RF433ANY_RAIL_LUT to compare the classification
+    // of durations by lookup table and by comparisons, and with and without
+    // RF433ANY_MULTI_BANDS to check two-band codes are not slowed down.
+
+#define TRACK_NB_PASSES 20
+
+void bench_track(const Decoder *pref) {
+    unsigned long total = 0;
+    unsigned long worst = 0;
+    uint32_t nb_edges = 0;
+    bool ok = true;
+
+    for (byte n = 0; n < TRACK_NB_PASSES; ++n) {
+        track_reset(&track);
+        for (uint16_t i = 0; i < nb_timings; ++i) {
+            unsigned long t0 = micros();
+            track.track_eat(i & 1, timings[i]);
+            unsigned long d = micros() - t0;
+            total += d;
+            if (d > worst)
+                worst = d;
+            ++nb_edges;
+        }
+        track_stop(&track);
+        Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+        ok = ok && same_data(pref, pdec);
+        delete pdec;
+    }
+    track_reset(&track);
+
+    serial_printf("track_eat  %s  ns/edge avg %lu  worst %lu\n",
+            ok ? "ok" : "KO", (unsigned long)((total * 1000.0) / nb_edges),
+            worst * 1000);
+    serial_printf("    rail lut %-3s  multi bands %-3s  RAM: Rail %u\n",
+#ifdef RF433ANY_RAIL_LUT
+            "on",
+#else
+            "off",
+#endif
+#ifdef RF433ANY_MULTI_BANDS
+            "on",
+#else
+            "off",
+#endif
+            (unsigned)sizeof(Rail));
+}
+
+// * ***************** ********************************************************
+// * Decoder selection ********************************************************
+// * ***************** ********************************************************
+
+    // Time spent by get_data() to decode the recorded input, per frame (one
+    // frame being one decoder of the chain returned). Most of it goes to
+    // finding out the coding of each frame (see DecoderProbe).
+    // Build with and without RF433ANY_DBG_NO_WORD_DECODING to compare the
+    // decoding of data a word at a time and a signal step at a time, and
+    // with and without RF433ANY_ARENA_SIZE to compare allocations in the
+    // arena and on the heap.
+
+#define SELECT_NB_PASSES 20
+
+void bench_select(const Decoder *pref) {
+    track_reset(&track);
+    for (uint16_t i = 0; i < nb_timings; ++i)
+        track.track_eat(i & 1, timings[i]);
+    track_stop(&track);
+
+    unsigned long duration = 0;
+    unsigned long nb_frames = 0;
+    bool ok = true;
+    for (byte n = 0; n < SELECT_NB_PASSES; ++n) {
+        unsigned long t0 = micros();
+        Decoder *pdec0 = track.get_data(RF433ANY_FD_ALL);
+        duration += micros() - t0;
+
+        for (Decoder *pdec = pdec0; pdec; pdec = pdec->get_next())
+            ++nb_frames;
+        Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+        ok = ok && same_data(pref, pdec);
+        delete pdec;
+        delete pdec0;
+    }
+    track_reset(&track);
+
+    if (!nb_frames)
+        nb_frames = 1;
+    serial_printf("select  %s  frames %lu  ns/frame %lu", ok ? "ok" : "KO",
+            nb_frames / SELECT_NB_PASSES,
+            (unsigned long)((duration * 1000.0) / nb_frames));
+#ifdef F_CPU
+    serial_printf("  cycles/frame %lu",
+            (unsigned long)((duration * (F_CPU / 1000000.0)) / nb_frames));
+#endif
+    serial_printf("\n");
+    serial_printf("    word decoding %s\n",
+#ifdef RF433ANY_DBG_NO_WORD_DECODING
+            "off"
+#else
+            "on"
+#endif
+            );
+#ifdef RF433ANY_ARENA_SIZE
+    arena_stats_t stats;
+    RF433any_arena.get_stats(&stats);
+    serial_printf("    arena %u bytes  max used %u  overflows %u\n",
+            (unsigned)RF433ANY_ARENA_SIZE, stats.max_used, stats.nb_overflows);
+#endif
+}
+
+// * ********************** ***************************************************
+// * Adaptive decoder order ***************************************************
+// * ********************** ***************************************************
+
+    // Time spent by get_data() per frame, replaying the code of the input,
+    // one frame in ADAPTIVE_OTHER_EVERY being the second code (the one after
+    // the line "-"), if any.
+    // With mostly Manchester frames (see corpus/manchester-heavy.txt),
+    // DecoderManchester becomes the favorite decoder (see DecoderHits) and
+    // is tried before DecoderProbe.
+    // Build with and without RF433ANY_ADAPTIVE_ORDER to compare.
+
+#define ADAPTIVE_NB_FRAMES   100
+#define ADAPTIVE_OTHER_EVERY  10
+
+void bench_adaptive(const Decoder *pref) {
+    Decoder *pref2 = nullptr;
+    if (nb_timings_all > nb_timings)
+        pref2 = decode_reference(nb_timings, nb_timings_all);
+#ifdef RF433ANY_ADAPTIVE_ORDER
+    track.reset_decoder_hits();
+#endif
+
+    unsigned long duration = 0;
+    unsigned long nb_frames = 0;
+    bool ok = true;
+    for (byte n = 0; n < ADAPTIVE_NB_FRAMES; ++n) {
+        bool other = (pref2 && (n % ADAPTIVE_OTHER_EVERY
+                                == ADAPTIVE_OTHER_EVERY - 1));
+        uint16_t first = (other ? nb_timings : 0);
+        uint16_t last = (other ? nb_timings_all : nb_timings);
+        track_reset(&track);
+        for (uint16_t i = first; i < last; ++i)
+            track.track_eat((i - first) & 1, timings[i]);
+        track_stop(&track);
+
+        unsigned long t0 = micros();
+        Decoder *pdec0 = track.get_data(RF433ANY_FD_ALL);
+        duration += micros() - t0;
+
+        for (Decoder *pdec = pdec0; pdec; pdec = pdec->get_next())
+            ++nb_frames;
+        Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+        ok = ok && same_data(other ? pref2 : pref, pdec);
+        delete pdec;
+        delete pdec0;
+    }
+    track_reset(&track);
+    if (pref2)
+        delete pref2;
+
+    if (!nb_frames)
+        nb_frames = 1;
+    serial_printf("adaptive  %s  frames %lu  ns/frame %lu", ok ? "ok" : "KO",
+            nb_frames, (unsigned long)((duration * 1000.0) / nb_frames));
+#ifdef F_CPU
+    serial_printf("  cycles/frame %lu",
+            (unsigned long)((duration * (F_CPU / 1000000.0)) / nb_frames));
+#endif
+    serial_printf("\n");
+#ifdef RF433ANY_ADAPTIVE_ORDER
+    serial_printf("    adaptive order on   hits T %u  N %u  M %u  U %u\n",
+            track.get_decoder_hits(RF433ANY_ID_TRIBIT),
+            track.get_decoder_hits(RF433ANY_ID_TRIBIT_INV),
+            track.get_decoder_hits(RF433ANY_ID_MANCHESTER),
+            track.get_decoder_hits(RF433ANY_ID_RAW_UNKNOWN_CODING));
+#else
+    serial_printf("    adaptive order off\n");
+#endif
+}
+
+// * **************** *********************************************************
+// * Decoding latency *********************************************************
+// * **************** *********************************************************
+
+    // Time spent in the main loop (do_events(), then get_data() once a code is
+    // received), split between the edges of the code and the last edge (the
+    // one that terminates the code). Callbacks are called at the end of the
+    // latter.
+    // With RF433ANY_INCREMENTAL_DECODING, decoding moves from the last edge
+    // to the edges of the code.
+
+#define LATENCY_NB_FRAMES    20
+#define LATENCY_MAX_GLITCHES  8
+
+void bench_latency(const Decoder *pref) {
+    unsigned long reception = 0;
+    unsigned long latency = 0;
+    byte nb_ok = 0;
+
+    for (byte n = 0; n < LATENCY_NB_FRAMES; ++n) {
+        track_reset(&track);
+            // The code is followed by glitches, as many as needed for Track
+            // to see it is over (after a separator, the first two timings are
+            // taken as the beginning of the next section, whatever they are).
+        for (uint16_t i = 0; i < nb_timings + LATENCY_MAX_GLITCHES; ++i) {
+            unsigned long t0 = micros();
+            track.ih_push_timing(i & 1, i < nb_timings ? timings[i] : 0);
+            bool got_data = track.do_events();
+            Decoder *pdec =
+                (got_data ? track.get_data(RF433ANY_FD_DECODED) : nullptr);
+            unsigned long d = micros() - t0;
+
+            if (got_data) {
+                latency += d;
+                if (same_data(pref, pdec))
+                    ++nb_ok;
+                delete pdec;
+                break;
+            }
+            reception += d;
+        }
+    }
+    track_reset(&track);
+
+    serial_printf("latency incremental %-3s  %s %u/%u  us/frame: reception "
+            "%lu  last edge %lu\n",
+#ifdef RF433ANY_INCREMENTAL_DECODING
+            "on",
+#else
+            "off",
+#endif
+            nb_ok == LATENCY_NB_FRAMES ? "ok" : "KO", nb_ok,
+            LATENCY_NB_FRAMES, reception / LATENCY_NB_FRAMES,
+            latency / LATENCY_NB_FRAMES);
+}
+
+// * *************** **********************************************************
+// * Recording width **********************************************************
+// * *************** **********************************************************
+
+    // RAM taken by the recording of codes, and time to record then decode the
+    // input, for the width of rails (RF433ANY_RECORDED_BITS) built with.
+    // The number of codes decoded tells how many repeats fit in
+    // RF433ANY_MAX_SECTIONS sections.
+
+#define WIDTH_NB_PASSES 20
+
+void bench_width() {
+    serial_printf("width %u bits  RAM: Section %u  RawCode %u  Track %u\n",
+            RF433ANY_RECORDED_BITS, (unsigned)sizeof(Section),
+            (unsigned)sizeof(RawCode), (unsigned)sizeof(Track));
+
+    unsigned long t_eat = 0;
+    unsigned long t_decode = 0;
+    byte nb_codes = 0;
+    for (byte n = 0; n < WIDTH_NB_PASSES; ++n) {
+        track_reset(&track);
+        unsigned long t0 = micros();
+        for (uint16_t i = 0; i < nb_timings; ++i)
+            track.track_eat(i & 1, timings[i]);
+        track_stop(&track);
+        t_eat += micros() - t0;
+
+        t0 = micros();
+        Decoder *pdec0 = track.get_data(RF433ANY_FD_DECODED);
+        t_decode += micros() - t0;
+
+        nb_codes = 0;
+        for (Decoder *pdec = pdec0; pdec; pdec = pdec->get_next())
+            ++nb_codes;
+        delete pdec0;
+    }
+    track_reset(&track);
+
+    serial_printf("    codes decoded %u  us/frame: record %lu  decode %lu\n",
+            nb_codes, t_eat / WIDTH_NB_PASSES, t_decode / WIDTH_NB_PASSES);
+}
+
+// * ****************** *******************************************************
+// * Back-to-back codes *******************************************************
+// * ****************** *******************************************************
+
+// Requires two codes in input, separated by a line "-" (see the test plan
+// round 6, in extras/testplan/multi), as if received from two remotes.
+//
+// The two codes are sent alternately, separated by a short burst of noise (as
+// output by receivers when no code is being transmitted), that ends the
+// reception of the previous code. Once a code is received, the main loop is
+// 'busy' (decoding, running callbacks, ...) during B2B_BUSY edges, then calls
+// treset(). Without a queue of codes (RF433ANY_RAWCODE_QUEUE set to 0), the
+// interrupt handler is detached in the meantime.
+
+#define B2B_NB_CODES    40
+#define B2B_DRAIN_EVERY  2 // Main loop calls do_events() every 2 edges
+#define B2B_NOISE_EDGES  8 // Edges of noise between two codes (even number)
+#define B2B_NOISE_D     30 // Duration of noise edges
+
+const uint16_t b2b_busy[] = { 0, 4, 16, 64 };
+
+struct b2b_t {
+    const BitVector *pcode[2];
+
+    uint16_t busy_edges;
+    uint16_t nb_sent;
+    uint16_t expected;      // Index of the next code expected
+    uint16_t nb_received;
+
+    uint32_t nb_edges;
+    uint16_t busy;
+    bool reset_after_busy;
+    uint32_t nb_edges_lost;
+};
+
+    // Returns true if Track got some data.
+bool b2b_receive(b2b_t *pb2b) {
+    if (!track.do_events())
+        return false;
+
+    Decoder *pdec0 = track.get_data(RF433ANY_FD_DECODED);
+    for (Decoder *pdec = pdec0; pdec; pdec = pdec->get_next()) {
+        const BitVector *pdata = pdec->get_pdata();
+        for (uint16_t c = pb2b->expected; pdata && c < pb2b->nb_sent; ++c) {
+            if (pb2b->pcode[c & 1] && !pdata->cmp(pb2b->pcode[c & 1])) {
+                ++pb2b->nb_received;
+                pb2b->expected = c + 1;
+                break;
+            }
+        }
+    }
+    delete pdec0;
+    return true;
+}
+
+void b2b_edge(b2b_t *pb2b, uint16_t d) {
+        // Interrupt handler
+    if (track.is_recording())
+        track.ih_push_timing(pb2b->nb_edges & 1, d);
+    else
+        ++pb2b->nb_edges_lost;
+    ++pb2b->nb_edges;
+
+        // Main loop
+    if (pb2b->busy) {
+        --pb2b->busy;
+        return;
+    }
+    if (pb2b->reset_after_busy) {
+        track.treset();
+        track.activate_recording();
+        pb2b->reset_after_busy = false;
+    }
+    if ((pb2b->nb_edges % B2B_DRAIN_EVERY) == 0 && b2b_receive(pb2b)) {
+        pb2b->busy = pb2b->busy_edges;
+        pb2b->reset_after_busy = true;
+    }
+}
+
+void bench_b2b_run(b2b_t *pb2b) {
+    pb2b->nb_sent = 0;
+    pb2b->expected = 0;
+    pb2b->nb_received = 0;
+    pb2b->nb_edges = 0;
+    pb2b->busy = 0;
+    pb2b->reset_after_busy = false;
+    pb2b->nb_edges_lost = 0;
+    track_reset(&track);
+    track.ih_reset_stats();
+    track.activate_recording();
+
+    for (uint16_t c = 0; c < B2B_NB_CODES; ++c) {
+        uint16_t first = (c & 1 ? nb_timings : 0);
+        uint16_t last = (c & 1 ? nb_timings_all : nb_timings);
+
+        for (byte i = 0; i < B2B_NOISE_EDGES; ++i)
+            b2b_edge(pb2b, B2B_NOISE_D);
+        ++pb2b->nb_sent;
+            // The first timing of a capture is the low level before the
+            // initialization sequence, it is replaced by noise.
+        b2b_edge(pb2b, B2B_NOISE_D);
+        for (uint16_t i = first + 1; i < last; ++i)
+            b2b_edge(pb2b, timings[i]);
+    }
+    for (byte i = 0; i < B2B_NOISE_EDGES; ++i)
+        b2b_edge(pb2b, B2B_NOISE_D);
+    while (pb2b->busy || pb2b->reset_after_busy)
+        b2b_edge(pb2b, B2B_NOISE_D);
+    while (b2b_receive(pb2b))
+        track.treset();
+    track_reset(&track);
+
+    IH_stats_t stats;
+    track.ih_get_stats(&stats);
+    serial_printf("b2b queue %u  busy %2u  received %2u/%u  ",
+            RF433ANY_RAWCODE_QUEUE, pb2b->busy_edges, pb2b->nb_received,
+            B2B_NB_CODES);
+    serial_printf("edges lost (detached) %4lu  ring drops %4u\n",
+            (unsigned long)pb2b->nb_edges_lost, stats.nb_dropped);
+}
+
+void bench_b2b() {
+    if (nb_timings_all == nb_timings) {
+        serial_printf("b2b: no second code in input, skipped\n");
+        return;
+    }
+
+    Decoder *pdec0 = decode_reference(0, nb_timings);
+    Decoder *pdec1 = decode_reference(nb_timings, nb_timings_all);
+    b2b_t b2b;
+    b2b.pcode[0] = (pdec0 ? pdec0->get_pdata() : nullptr);
+    b2b.pcode[1] = (pdec1 ? pdec1->get_pdata() : nullptr);
+
+    for (byte i = 0; i < sizeof(b2b_busy) / sizeof(*b2b_busy); ++i) {
+        b2b.busy_edges = b2b_busy[i];
+        bench_b2b_run(&b2b);
+    }
+
+    delete pdec0;
+    delete pdec1;
+}
+
+// * ****** *******************************************************************
+// * Jitter *******************************************************************
+// * ****** *******************************************************************
+
+    // The input is replayed JITTER_NB_FRAMES times, each timing being moved
+    // by a random amount of up to +/- level% (levels in jitter_levels[]).
+    // Prints how many replays decode to the same data as the reference,
+    // and the time spent by track_eat() per timing.
+    // Build with and without RF433ANY_ADAPTIVE_BANDS to compare.
+
+#define JITTER_NB_FRAMES 50
+
+const byte jitter_levels[] = { 0, 5, 10, 15, 20, 25, 30 };
+
+void bench_jitter(const Decoder *pref) {
+    serial_printf("jitter  adaptive bands %s\n",
+#ifdef RF433ANY_ADAPTIVE_BANDS
+            "on"
+#else
+            "off"
+#endif
+            );
+
+    lcg_seed(14);
+    for (byte l = 0; l < sizeof(jitter_levels); ++l) {
+        byte level = jitter_levels[l];
+        byte nb_ok = 0;
+        unsigned long total = 0;
+        uint32_t nb_edges = 0;
+
+        for (byte n = 0; n < JITTER_NB_FRAMES; ++n) {
+            track_reset(&track);
+            for (uint16_t i = 0; i < nb_timings; ++i) {
+                    // Random value in [-level * 20, level * 20], the
+                    // timing being moved by that many 2000th
+                long j = (long)(lcg_rand() % (level * 40 + 1)) - level * 20;
+                uint16_t d = (uint16_t)(timings[i] + timings[i] * j / 2000);
+                unsigned long t0 = micros();
+                track.track_eat(i & 1, d);
+                total += micros() - t0;
+                ++nb_edges;
+            }
+            track_stop(&track);
+            Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+            if (same_data(pref, pdec))
+                ++nb_ok;
+            delete pdec;
+        }
+        track_reset(&track);
+
+        serial_printf("    +/-%2u%%  decoded %2u/%u  ns/edge avg %lu\n", level,
+                nb_ok, JITTER_NB_FRAMES,
+                (unsigned long)((total * 1000.0) / nb_edges));
+    }
+}
+
+// * ********* ****************************************************************
+// * BitVector ****************************************************************
+// * ********* ****************************************************************
+
+    // Builds BITVECTOR_NB_VECTORS pairs of vectors of each size in
+    // bitvector_sizes[], one bit at a time with add_bit() and by chunks of 16
+    // bits with add_bits(), and compares each pair with cmp(). Prints the time
+    // spent per vector (new and delete included), and the number of pairs that
+    // differ or of bits that get_nth_bit() reads wrong, that must be 0. Does
+    // not depend on the input.
+
+#define BITVECTOR_NB_VECTORS 200
+#define BITVECTOR_MAX_BITS   512
+
+const uint16_t bitvector_sizes[] = {
+    8, 16, 32, 64, 128, 256, BITVECTOR_MAX_BITS
+};
+
+void bench_bitvector() {
+    serial_printf("bitvector  word size %u bits\n",
+            (unsigned)(8 * sizeof(bitvector_word_t)));
+
+        // Drawn beforehand, not to time lcg_rand()
+    uint16_t bits[BITVECTOR_MAX_BITS / 16];
+    lcg_seed(20);
+    for (byte i = 0; i < sizeof(bits) / sizeof(*bits); ++i)
+        bits[i] = lcg_rand();
+
+    for (byte s = 0; s < sizeof(bitvector_sizes) / sizeof(*bitvector_sizes);
+            ++s) {
+        uint16_t nb = bitvector_sizes[s];
+        unsigned long t_bit = 0;
+        unsigned long t_bits = 0;
+        unsigned long t_cmp = 0;
+        uint16_t nb_diff = 0;
+
+        for (uint16_t n = 0; n < BITVECTOR_NB_VECTORS; ++n) {
+            unsigned long t0 = micros();
+            BitVector *p1 = new BitVector();
+            for (uint16_t i = 0; i < nb; ++i)
+                p1->add_bit((bits[i >> 4] >> (15 - (i & 15))) & 1);
+            delete p1;
+            t_bit += micros() - t0;
+
+            t0 = micros();
+            BitVector *p2 = new BitVector();
+            for (uint16_t i = 0; i < nb; i += 16)
+                p2->add_bits(bits[i >> 4] >> (nb < 16 ? 16 - nb : 0),
+                        nb < 16 ? nb : 16);
+            delete p2;
+            t_bits += micros() - t0;
+        }
+
+        BitVector *p1 = new BitVector();
+        BitVector *p2 = new BitVector();
+        for (uint16_t i = 0; i < nb; ++i) {
+            p1->add_bit((bits[i >> 4] >> (15 - (i & 15))) & 1);
+            p2->add_bit((bits[i >> 4] >> (15 - (i & 15))) & 1);
+        }
+        for (uint16_t n = 0; n < BITVECTOR_NB_VECTORS; ++n) {
+            unsigned long t0 = micros();
+            if (p1->cmp(p2))
+                ++nb_diff;
+            t_cmp += micros() - t0;
+        }
+            // Bit numbering starts at the last bit added
+        for (uint16_t i = 0; i < nb; ++i) {
+            if (p1->get_nth_bit(nb - 1 - i)
+                    != ((bits[i >> 4] >> (15 - (i & 15))) & 1))
+                ++nb_diff;
+        }
+        delete p1;
+        delete p2;
+
+        serial_printf("    %3u bits  ns/vector add_bit %6lu  add_bits %6lu  "
+                "cmp %5lu", nb,
+                (unsigned long)((t_bit * 1000.0) / BITVECTOR_NB_VECTORS),
+                (unsigned long)((t_bits * 1000.0) / BITVECTOR_NB_VECTORS),
+                (unsigned long)((t_cmp * 1000.0) / BITVECTOR_NB_VECTORS));
+        serial_printf("  mismatches %u\n", nb_diff);
+    }
+}
+
+// * ***************** ********************************************************
+// * Callback dispatch ********************************************************
+// * ***************** ********************************************************
+
+    // For each number of callbacks in callback_counts[], registers as many
+    // codes on a Track of its own: random codes of the length and encoding of
+    // the reference, then the reference itself (last one registered). The
+    // input is then replayed CALLBACK_NB_FRAMES times through
+    // check_registered_callbacks(). Prints the time spent per frame beyond
+    // get_data() (done by check_registered_callbacks() as well), that is, in
+    // finding the callbacks of the code.
+    // Callbacks cannot be unregistered: these Track objects are never deleted.
+    // Build with and without RF433ANY_CALLBACK_INDEX to compare.
+
+#define CALLBACK_NB_FRAMES 50
+
+#ifdef __AVR__
+const uint16_t callback_counts[] = { 10, 20 };
+#else
+const uint16_t callback_counts[] = { 10, 100, 1000 };
+#endif
+
+uint16_t callback_nb_called;
+void callback_on_code(void *data) {
+    ++*(uint16_t *)data;
+}
+
+void feed_reference(Track *ptrack) {
+    track_reset(ptrack);
+    for (uint16_t i = 0; i < nb_timings; ++i)
+        ptrack->track_eat(i & 1, timings[i]);
+    track_stop(ptrack);
+}
+
+void bench_callback(const Decoder *pref) {
+    serial_printf("callback  index %s\n",
+#ifdef RF433ANY_CALLBACK_INDEX
+            "on"
+#else
+            "off"
+#endif
+            );
+
+    const BitVector *pdata = pref->get_pdata();
+    lcg_seed(21);
+    for (byte c = 0; c < sizeof(callback_counts) / sizeof(*callback_counts);
+            ++c) {
+        uint16_t nb = callback_counts[c];
+        Track *ptrack = new TrackReplay();
+        for (uint16_t k = 0; k + 1 < nb; ++k) {
+            BitVector *pcode = new BitVector();
+            for (short i = 0; i < pdata->get_nb_bits(); ++i)
+                pcode->add_bit(lcg_rand() & 1);
+            ptrack->register_callback(pref->get_id(), pcode,
+                    &callback_nb_called, callback_on_code, 0);
+        }
+        ptrack->register_callback(pref->get_id(), pdata, &callback_nb_called,
+                callback_on_code, 0);
+
+        unsigned long t_get_data = 0;
+        unsigned long t_check = 0;
+        callback_nb_called = 0;
+        for (byte n = 0; n < CALLBACK_NB_FRAMES; ++n) {
+            feed_reference(ptrack);
+            unsigned long t0 = micros();
+            Decoder *pdec = ptrack->get_data(
+                    RF433ANY_FD_DECODED | RF433ANY_FD_DEDUP);
+            t_get_data += micros() - t0;
+            delete pdec;
+
+            feed_reference(ptrack);
+            t0 = micros();
+            ptrack->check_registered_callbacks();
+            t_check += micros() - t0;
+        }
+        track_reset(ptrack);
+
+        serial_printf("    %4u callbacks  called %3u/%u  ns/frame %lu\n", nb,
+                callback_nb_called, CALLBACK_NB_FRAMES,
+                t_check > t_get_data ?
+                (unsigned long)(((t_check - t_get_data) * 1000.0)
+                                / CALLBACK_NB_FRAMES) : 0UL);
+    }
+}
+
+// * **************** *********************************************************
+// * Masked callbacks *********************************************************
+// * **************** *********************************************************
+
+// Requires RF433ANY_MASKED_CALLBACKS to be defined in RF433any.h.
+
+    // For each number of patterns in masked_counts[], registers as many
+    // callbacks with a mask on a Track of its own: random values, each with
+    // one of MASKED_NB_MASKS masks (the first quarter of the bits of the
+    // reference, its first half, its last half and its first three quarters),
+    // then the reference with the mask of its first half. The input is then
+    // replayed MASKED_NB_FRAMES times through check_registered_callbacks().
+    // Prints the time spent per frame beyond get_data(), and for comparison,
+    // the time spent by a loop calling BitVector::matches() on each pattern,
+    // as one would do in a callback registered with RF433ANY_ID_ANY_ENCODING.
+    // Patterns cannot be unregistered: these Track objects and the masks are
+    // never deleted.
+
+#define MASKED_NB_FRAMES 50
+#define MASKED_NB_MASKS   4
+
+#ifdef __AVR__
+const uint16_t masked_counts[] = { 10, 20 };
+#else
+const uint16_t masked_counts[] = { 100, 1000, 4000 };
+#endif
+
+struct masked_pattern_t {
+    BitVector *pvalue;
+    const BitVector *pmask;
+};
+
+    // n bits, the ones received from first-th to last-th being set
+BitVector *masked_make_mask(short n, short first, short last) {
+    BitVector *pmask = new BitVector();
+    for (short i = 0; i < n; ++i)
+        pmask->add_bit(i >= first && i <= last);
+    return pmask;
+}
+
+void bench_masked(const Decoder *pref) {
+#ifdef RF433ANY_MASKED_CALLBACKS
+    const BitVector *pdata = pref->get_pdata();
+    short n = pdata->get_nb_bits();
+    const BitVector *pmasks[MASKED_NB_MASKS] = {
+        masked_make_mask(n, 0, n / 4 - 1),
+        masked_make_mask(n, 0, n / 2 - 1),
+        masked_make_mask(n, n / 2, n - 1),
+        masked_make_mask(n, 0, 3 * n / 4 - 1)
+    };
+
+    lcg_seed(22);
+    for (byte c = 0; c < sizeof(masked_counts) / sizeof(*masked_counts); ++c) {
+        uint16_t nb = masked_counts[c];
+        masked_pattern_t *patterns =
+            (masked_pattern_t*)malloc(nb * sizeof(masked_pattern_t));
+        Track *ptrack = new TrackReplay();
+        for (uint16_t k = 0; k < nb; ++k) {
+            BitVector *pvalue = new BitVector();
+            for (short i = 0; i < n; ++i)
+                pvalue->add_bit(lcg_rand() & 1);
+            patterns[k].pvalue = pvalue;
+            patterns[k].pmask = pmasks[k % MASKED_NB_MASKS];
+            if (k == nb - 1) {
+                patterns[k].pvalue = (BitVector*)pdata;
+                patterns[k].pmask = pmasks[1];
+                delete pvalue;
+            }
+            ptrack->register_callback(pref->get_id(), patterns[k].pvalue,
+                    patterns[k].pmask, &callback_nb_called, callback_on_code,
+                    0);
+        }
+
+        unsigned long t_get_data = 0;
+        unsigned long t_check = 0;
+        unsigned long t_loop = 0;
+        uint16_t nb_loop_matches = 0;
+        callback_nb_called = 0;
+        for (byte f = 0; f < MASKED_NB_FRAMES; ++f) {
+            feed_reference(ptrack);
+            unsigned long t0 = micros();
+            Decoder *pdec = ptrack->get_data(
+                    RF433ANY_FD_DECODED | RF433ANY_FD_DEDUP);
+            t_get_data += micros() - t0;
+
+            t0 = micros();
+            for (Decoder *p = pdec; p; p = p->get_next()) {
+                for (uint16_t k = 0; k < nb; ++k) {
+                    if (p->get_pdata()->matches(patterns[k].pvalue,
+                                patterns[k].pmask))
+                        ++nb_loop_matches;
+                }
+            }
+            t_loop += micros() - t0;
+            delete pdec;
+
+            feed_reference(ptrack);
+            t0 = micros();
+            ptrack->check_registered_callbacks();
+            t_check += micros() - t0;
+        }
+        track_reset(ptrack);
+        free(patterns);
+        serial_printf("masked  %4u patterns  called %3u (loop %3u)  "
+                "ns/frame %lu", nb, callback_nb_called, nb_loop_matches,
+                t_check > t_get_data ?
+                (unsigned long)(((t_check - t_get_data) * 1000.0)
+                                / MASKED_NB_FRAMES) : 0UL);
+        serial_printf("  loop ns/frame %lu\n",
+                (unsigned long)((t_loop * 1000.0) / MASKED_NB_FRAMES));
+    }
+#else
+    (void)pref;
+    serial_printf("masked: RF433ANY_MASKED_CALLBACKS not defined, skipped\n");
+#endif
+}
+
+// * ********* ****************************************************************
+// * Code book ****************************************************************
+// * ********* ****************************************************************
+
+    // Builds a code book of CODEBOOK_NB_ENTRIES random codes of 12, 24 or 32
+    // bits, plus the reference, then looks up the code of each entry, and as
+    // many codes that are (most likely) not in the code book. Prints the time
+    // per lookup, and for comparison, the time of a linear search on
+    // CODEBOOK_NB_LINEAR codes. Then the input is replayed CODEBOOK_NB_FRAMES
+    // times through check_registered_callbacks(), on a Track of its own (never
+    // deleted) that has the code book: prints the time spent per frame beyond
+    // get_data(), provided RF433ANY_CODEBOOK is defined in RF433any.h.
+    // The code book is built in RAM, so, not on AVR where it must be in flash
+    // (see extras/codebook/codebook.py and test plan round 13).
+
+#define CODEBOOK_NB_ENTRIES 5000
+#define CODEBOOK_NB_LINEAR   100
+#define CODEBOOK_NB_FRAMES    50
+
+#ifndef __AVR__
+int codebook_cmp(const void *p1, const void *p2) {
+    const codebook_entry_t *pe1 = (const codebook_entry_t *)p1;
+    const codebook_entry_t *pe2 = (const codebook_entry_t *)p2;
+    if (pe1->nb_bits != pe2->nb_bits)
+        return pe1->nb_bits < pe2->nb_bits ? -1 : 1;
+    if (pe1->code != pe2->code)
+        return pe1->code < pe2->code ? -1 : 1;
+    return 0;
+}
+
+uint32_t codebook_rand_code(byte nb_bits) {
+    uint32_t code = ((uint32_t)lcg_rand() << 16) | lcg_rand();
+    return nb_bits < 32 ? code & (((uint32_t)1 << nb_bits) - 1) : code;
+}
+
+uint16_t codebook_nb_actions;
+void codebook_on_action(uint16_t action, void *data) {
+    (void)action;
+    ++*(uint16_t *)data;
+}
+#endif
+
+void bench_codebook(const Decoder *pref) {
+#ifdef __AVR__
+    (void)pref;
+    serial_printf("codebook: built in RAM, not on AVR, skipped\n");
+#else
+    const BitVector *pdata = pref->get_pdata();
+    if (pdata->get_nb_bits() > 32) {
+        serial_printf("codebook: reference has more than 32 bits, skipped\n");
+        return;
+    }
+
+    const byte sizes[] = { 12, 24, 32 };
+    const byte encodings[] = {
+        RF433ANY_ID_TRIBIT, RF433ANY_ID_TRIBIT_INV, RF433ANY_ID_MANCHESTER
+    };
+    codebook_entry_t *book = (codebook_entry_t*)malloc(
+            (CODEBOOK_NB_ENTRIES + 1) * sizeof(codebook_entry_t));
+    lcg_seed(23);
+    for (uint16_t i = 0; i < CODEBOOK_NB_ENTRIES; ++i) {
+        book[i].nb_bits = sizes[lcg_rand() % sizeof(sizes)];
+        book[i].code = codebook_rand_code(book[i].nb_bits);
+        book[i].encoding = encodings[lcg_rand() % sizeof(encodings)];
+        book[i].action = i + 1;
+    }
+    book[CODEBOOK_NB_ENTRIES].nb_bits = pdata->get_nb_bits();
+    book[CODEBOOK_NB_ENTRIES].code = pdata->get_uint32();
+    book[CODEBOOK_NB_ENTRIES].encoding = pref->get_id();
+    book[CODEBOOK_NB_ENTRIES].action = 0;
+    const uint16_t nb_entries = CODEBOOK_NB_ENTRIES + 1;
+    qsort(book, nb_entries, sizeof(*book), codebook_cmp);
+
+    uint16_t nb_found = 0;
+    unsigned long t0 = micros();
+    for (uint16_t i = 0; i < nb_entries; ++i) {
+        if (codebook_find(book, nb_entries, book[i].nb_bits, book[i].code)
+                < nb_entries)
+            ++nb_found;
+    }
+    unsigned long t_found = micros() - t0;
+
+    uint16_t nb_absent = 0;
+    t0 = micros();
+    for (uint16_t i = 0; i < nb_entries; ++i) {
+            // Not predictable by the branch predictor, just like the codes
+        byte nb_bits = sizes[i % sizeof(sizes)];
+        if (codebook_find(book, nb_entries, nb_bits,
+                    codebook_rand_code(nb_bits)) == nb_entries)
+            ++nb_absent;
+    }
+    unsigned long t_absent = micros() - t0;
+
+    uint16_t nb_linear = 0;
+    t0 = micros();
+    for (uint16_t i = 0; i < CODEBOOK_NB_LINEAR; ++i) {
+        const codebook_entry_t *pe = &book[(i * 7919UL) % nb_entries];
+        for (uint16_t j = 0; j < nb_entries; ++j) {
+            if (book[j].nb_bits == pe->nb_bits && book[j].code == pe->code) {
+                ++nb_linear;
+                break;
+            }
+        }
+    }
+    unsigned long t_linear = micros() - t0;
+
+    serial_printf("codebook  %u entries  found %u/%u  ns/lookup %lu\n",
+            nb_entries, nb_found, nb_entries,
+            (unsigned long)((t_found * 1000.0) / nb_entries));
+    serial_printf("    absent %u/%u  ns/lookup %lu\n", nb_absent, nb_entries,
+            (unsigned long)((t_absent * 1000.0) / nb_entries));
+    serial_printf("    linear search  found %u/%u  ns/lookup %lu\n", nb_linear,
+            CODEBOOK_NB_LINEAR,
+            (unsigned long)((t_linear * 1000.0) / CODEBOOK_NB_LINEAR));
+
+#ifdef RF433ANY_CODEBOOK
+    Track *ptrack = new TrackReplay();
+    ptrack->register_codebook(book, nb_entries, codebook_on_action,
+            &codebook_nb_actions);
+    unsigned long t_get_data = 0;
+    unsigned long t_check = 0;
+    codebook_nb_actions = 0;
+    for (byte f = 0; f < CODEBOOK_NB_FRAMES; ++f) {
+        feed_reference(ptrack);
+        t0 = micros();
+        Decoder *pdec = ptrack->get_data(
+                RF433ANY_FD_DECODED | RF433ANY_FD_DEDUP);
+        t_get_data += micros() - t0;
+        delete pdec;
+
+        feed_reference(ptrack);
+        t0 = micros();
+        ptrack->check_registered_callbacks();
+        t_check += micros() - t0;
+    }
+    track_reset(ptrack);
+
+    serial_printf("    dispatch  actions %u/%u  ns/frame %lu\n",
+            codebook_nb_actions, CODEBOOK_NB_FRAMES,
+            t_check > t_get_data ?
+            (unsigned long)(((t_check - t_get_data) * 1000.0)
+                            / CODEBOOK_NB_FRAMES) : 0UL);
+        // book is not freed, the Track object above keeps using it
+#else
+    serial_printf("    dispatch: RF433ANY_CODEBOOK not defined, skipped\n");
+    free(book);
+#endif
+#endif
+}
+
+// * ************* ************************************************************
+// * Majority vote ************************************************************
+// * ************* ************************************************************
+
+    // The input is replayed VOTE_NB_FRAMES times, with as many bit flips as
+    // in vote_flips[] injected in each replay: a flip swaps two timings that
+    // follow each other, one short and one long (for Tri-bit codes, that
+    // inverts one bit). Prints how many replays give the code of the
+    // reference as their first code, with RF433ANY_FD_DEDUP, and with
+    // RF433ANY_FD_VOTE as well (along with the average confidence). Also
+    // prints the time spent in get_data() in each case.
+    // The input should have several copies of its code (for example,
+    // testplan/decoder/40).
+
+#define VOTE_NB_FRAMES 100
+
+const byte vote_flips[] = { 0, 1, 2, 3, 4 };
+
+uint16_t vote_timings[MAX_TIMINGS];
+
+    // Returns true if the first code of pdec0 is the one of pref
+bool vote_first_ok(const Decoder *pref, const Decoder *pdec0) {
+    return pdec0 && pdec0->get_id() == pref->get_id()
+           && !pdec0->get_pdata()->cmp(pref->get_pdata());
+}
+
+    // Swaps two timings that follow each other, if one is short and the other
+    // long (leaving alone the separators and initialization sequences, much
+    // longer). Returns true if it did.
+bool vote_flip(uint16_t i) {
+    uint16_t a = vote_timings[i];
+    uint16_t b = vote_timings[i + 1];
+    uint16_t lo = (a < b ? a : b);
+    uint16_t hi = (a < b ? b : a);
+    if (!lo || hi * 2 < lo * 3 || hi > lo * 4)
+        return false;
+    vote_timings[i] = b;
+    vote_timings[i + 1] = a;
+    return true;
+}
+
+unsigned long vote_decode(uint16_t filter, Decoder **ppdec) {
+    track_reset(&track);
+    for (uint16_t i = 0; i < nb_timings; ++i)
+        track.track_eat(i & 1, vote_timings[i]);
+    track_stop(&track);
+    unsigned long t0 = micros();
+    *ppdec = track.get_data(filter);
+    return micros() - t0;
+}
+
+void bench_vote(const Decoder *pref) {
+    if (nb_timings < 4) {
+        serial_printf("vote: input too short, skipped\n");
+        return;
+    }
+
+    lcg_seed(25);
+    for (byte l = 0; l < sizeof(vote_flips); ++l) {
+        byte nb_flips = vote_flips[l];
+        uint16_t nb_ok_dedup = 0;
+        uint16_t nb_ok_vote = 0;
+        uint32_t total_confidence = 0;
+        unsigned long t_dedup = 0;
+        unsigned long t_vote = 0;
+
+        for (byte n = 0; n < VOTE_NB_FRAMES; ++n) {
+            memcpy(vote_timings, timings, nb_timings * sizeof(*timings));
+            for (byte f = 0; f < nb_flips; ++f) {
+                    // Several tries to find two timings to swap
+                for (byte k = 0; k < 20; ++k) {
+                    if (vote_flip(1 + lcg_rand() % (nb_timings - 2)))
+                        break;
+                }
+            }
+
+            Decoder *pdec;
+            t_dedup += vote_decode(RF433ANY_FD_DECODED | RF433ANY_FD_DEDUP,
+                    &pdec);
+            if (vote_first_ok(pref, pdec))
+                ++nb_ok_dedup;
+            delete pdec;
+
+            t_vote += vote_decode(RF433ANY_FD_DECODED | RF433ANY_FD_DEDUP
+                    | RF433ANY_FD_VOTE, &pdec);
+            if (vote_first_ok(pref, pdec)) {
+                ++nb_ok_vote;
+                total_confidence += pdec->get_confidence();
+            }
+            delete pdec;
+        }
+        track_reset(&track);
+
+        serial_printf("vote  flips %u  first code ok: dedup %3u/%u  "
+                "vote %3u/%u", nb_flips, nb_ok_dedup, VOTE_NB_FRAMES,
+                nb_ok_vote, VOTE_NB_FRAMES);
+        serial_printf(" (confidence %3u%%)", nb_ok_vote ?
+                (unsigned)(total_confidence / nb_ok_vote) : 0);
+        serial_printf("  ns/get_data %lu / %lu\n",
+                (unsigned long)((t_dedup * 1000.0) / VOTE_NB_FRAMES),
+                (unsigned long)((t_vote * 1000.0) / VOTE_NB_FRAMES));
+    }
+}
+
+void loop() {
+    read_timings_from_usb();
+
+    serial_printf("----- BEGIN TEST -----\n");
+
+    bench_b2b();
+
+    bench_width();
+
+    bench_bitvector();
+
+    Decoder *pref = decode_reference(0, nb_timings);
+    bench_squelch(pref);
+    if (!pref) {
+        serial_printf("No decoded data in reference run, other benchmarks "
+                "skipped\n");
+    } else {
+        bench_ring(pref);
+        bench_drain(pref);
+        bench_isr(pref);
+        bench_storm(pref);
+        bench_latency(pref);
+        bench_track(pref);
+        bench_select(pref);
+        bench_adaptive(pref);
+        bench_jitter(pref);
+        bench_callback(pref);
+        bench_masked(pref);
+        bench_codebook(pref);
+        bench_vote(pref);
+        delete pref;
+    }
+
+    serial_printf("----- END TEST -----\n");
+}
+
+// vim: ts=4:sw=4:tw=80:et
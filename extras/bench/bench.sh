@@ -0,0 +1,55 @@
+#!/usr/bin/bash
+
+# bench.sh
+
+# Run the RF433any benchmarks against one or more timing files, typically
+# taken from the test plan (extras/testplan/*/*/code*).
+# Requires an Arduino plugged on PC.
+
+# Copyright 2021 Sébastien Millet
+#
+# `RF433any' is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as
+# published by the Free Software Foundation, either version 3 of the
+# License, or (at your option) any later version.
+#
+# `RF433any' is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program. If not, see
+# <https://www.gnu.org/licenses>.
+
+set -euo pipefail
+
+PORT=/dev/ttyUSB0
+
+if [ -z "${1:-}" ]; then
+    echo "Usage:"
+    echo "  ./bench.sh code_file..."
+    echo
+    echo "You have to update the variable PORT defined at the"
+    echo "beginning of this script. At the moment it is:"
+    echo "${PORT}"
+    echo
+    echo "Example:"
+    echo "  ./bench.sh ../testplan/decoder/*/code*"
+    echo "  ./bench.sh corpus/manchester-heavy.txt"
+    exit 1
+fi
+
+./am2 -R bench.ino -u
+stty -F "${PORT}" -hupcl -echo 115200
+
+for f in "$@"; do
+    echo "== ${f}"
+    ../testplan/read_test_result_from_board.sh "${PORT}" &
+    sleep 0.2
+    cat "${f}" > "${PORT}"
+    echo "." > "${PORT}"
+    wait
+done
+
+exit 0
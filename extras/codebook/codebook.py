@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+
+# codebook.py
+
+# Generate a code book for RF433any (see Track::register_codebook()) from a
+# list of codes.
+
+# Copyright 2021 Sébastien Millet
+#
+# `RF433any' is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as
+# published by the Free Software Foundation, either version 3 of the
+# License, or (at your option) any later version.
+#
+# `RF433any' is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this program. If not, see
+# <https://www.gnu.org/licenses>.
+
+# Input: one code per line, made of the encoding, the number of bits, the code
+# (hexadecimal, the last bit received being the least significant one) and
+# the action number, separated by spaces. The encoding is the letter that
+# get_id_letter() returns (T, N or M), or * for any encoding. Anything after
+# a # is ignored.
+#
+#   # Garage door
+#   T 24 0x5a6b7c 1
+#
+# Output: a header file that defines the table (in flash) and its number of
+# entries, sorted as RF433any expects. Codes that are the same keep the order
+# of the input.
+
+import argparse
+import re
+import sys
+
+ENCODINGS = {
+    'T': 'RF433ANY_ID_TRIBIT',
+    'N': 'RF433ANY_ID_TRIBIT_INV',
+    'M': 'RF433ANY_ID_MANCHESTER',
+    '*': 'RF433ANY_ID_ANY_ENCODING',
+}
+
+
+def fatal(msg):
+    sys.stderr.write('codebook.py: {}\n'.format(msg))
+    sys.exit(1)
+
+
+def read_entries(f, filename):
+    entries = []
+    for n, line in enumerate(f, 1):
+        line = line.split('#', 1)[0].strip()
+        if not line:
+            continue
+        fields = line.split()
+        where = '{}:{}'.format(filename, n)
+        if len(fields) != 4:
+            fatal('{}: 4 fields expected'.format(where))
+        enc, nb_bits, code, action = fields
+        if enc not in ENCODINGS:
+            fatal('{}: unknown encoding "{}"'.format(where, enc))
+        try:
+            nb_bits = int(nb_bits)
+            code = int(code, 16)
+            action = int(action, 0)
+        except ValueError:
+            fatal('{}: bad number'.format(where))
+        if nb_bits < 1 or nb_bits > 32:
+            fatal('{}: number of bits must be from 1 to 32'.format(where))
+        if code >= 1 << nb_bits:
+            fatal('{}: code has more than {} bits'.format(where, nb_bits))
+        if action < 0 or action > 0xFFFF:
+            fatal('{}: action must be from 0 to 65535'.format(where))
+        entries.append((nb_bits, code, enc, action))
+    return entries
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Generate a code book for RF433any.')
+    parser.add_argument('input', nargs='?', default='-',
+                        help='list of codes (default: standard input)')
+    parser.add_argument('-n', '--name', default='codebook',
+                        help='name of the table (default: codebook)')
+    args = parser.parse_args()
+
+    if not re.match(r'^[A-Za-z_][A-Za-z0-9_]*$', args.name):
+        fatal('"{}" is not a valid C++ name'.format(args.name))
+
+    if args.input == '-':
+        entries = read_entries(sys.stdin, '<stdin>')
+    else:
+        with open(args.input) as f:
+            entries = read_entries(f, args.input)
+    if not entries:
+        fatal('no code')
+    if len(entries) > 0xFFFF:
+        fatal('too many codes ({}, 65535 at most)'.format(len(entries)))
+
+    # sort() is stable: same codes keep the order of the input
+    entries.sort(key=lambda e: (e[0], e[1]))
+
+    guard = '_{}_H'.format(args.name.upper())
+    out = sys.stdout
+    out.write('// {}.h\n\n'.format(args.name))
+    out.write('// Generated by codebook.py, do not edit.\n\n')
+    out.write('#ifndef {}\n#define {}\n\n'.format(guard, guard))
+    out.write('#include "RF433any.h"\n\n')
+    out.write('#define {}_NB_ENTRIES {}\n\n'.format(args.name.upper(),
+                                                   len(entries)))
+    out.write('const codebook_entry_t {}[] PROGMEM = {{\n'.format(args.name))
+    for nb_bits, code, enc, action in entries:
+        out.write('    {{ 0x{:08x}UL, {:2d}, {}, {} }},\n'.format(
+            code, nb_bits, ENCODINGS[enc], action))
+    out.write('}};\n\n#endif // {}\n'.format(guard))
+
+
+if __name__ == '__main__':
+    main()
+
+# vim: ts=4:sw=4:tw=80:et
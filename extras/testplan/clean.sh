@@ -20,3 +20,45 @@ for d in [0-9][0-9]; do
     rm -f "${d}"/tmpout*.txt
 done
 
+
+cd ../multi
+
+for d in [0-9][0-9]; do
+    rm -f "${d}"/tmpout*.txt
+done
+
+cd ../idle
+
+for d in [0-9][0-9]; do
+    rm -f "${d}"/tmpout*.txt
+done
+
+cd ../stream
+
+for d in [0-9][0-9]; do
+    rm -f "${d}"/tmpout*.txt
+done
+
+cd ../multiwidth
+
+for d in [0-9][0-9]; do
+    rm -f "${d}"/tmpout*.txt
+done
+
+cd ../worddec
+
+for d in [0-9][0-9]; do
+    rm -f "${d}"/tmpout*.txt
+done
+
+cd ../replay
+
+for d in [0-9][0-9]; do
+    rm -f "${d}"/tmpout*.txt
+done
+
+cd ../vote
+
+for d in [0-9][0-9]; do
+    rm -f "${d}"/tmpout*.txt
+done
@@ -195,7 +195,7 @@ void loop() {
 
     track.treset();
     while (track.get_trk() != TRK_DATA && sim_int_count <= sim_timings_count) {
-        Track::ih_handle_interrupt();
+        track.ih_handle_interrupt();
         track.do_events();
     }
     track.force_stop_recv();
@@ -0,0 +1,65 @@
+// codebook.h
+
+// Generated by codebook.py, do not edit.
+
+#ifndef _CODEBOOK_H
+#define _CODEBOOK_H
+
+#include "RF433any.h"
+
+#define CODEBOOK_NB_ENTRIES 50
+
+const codebook_entry_t codebook[] PROGMEM = {
+    { 0x0000016eUL,  9, RF433ANY_ID_TRIBIT, 1 },
+    { 0x0000016eUL,  9, RF433ANY_ID_ANY_ENCODING, 2 },
+    { 0x0000016eUL,  9, RF433ANY_ID_TRIBIT_INV, 3 },
+    { 0x0000016fUL,  9, RF433ANY_ID_TRIBIT, 5 },
+    { 0x0000016eUL, 10, RF433ANY_ID_TRIBIT, 4 },
+    { 0x0000009fUL, 12, RF433ANY_ID_TRIBIT_INV, 124 },
+    { 0x0000015fUL, 12, RF433ANY_ID_TRIBIT, 106 },
+    { 0x00000264UL, 12, RF433ANY_ID_TRIBIT_INV, 130 },
+    { 0x00000312UL, 12, RF433ANY_ID_MANCHESTER, 103 },
+    { 0x0000052cUL, 12, RF433ANY_ID_MANCHESTER, 121 },
+    { 0x00000555UL, 12, RF433ANY_ID_ANY_ENCODING, 8 },
+    { 0x00000555UL, 12, RF433ANY_ID_TRIBIT_INV, 9 },
+    { 0x00000555UL, 12, RF433ANY_ID_TRIBIT, 10 },
+    { 0x000005cdUL, 12, RF433ANY_ID_MANCHESTER, 113 },
+    { 0x000005e7UL, 12, RF433ANY_ID_MANCHESTER, 111 },
+    { 0x00000747UL, 12, RF433ANY_ID_MANCHESTER, 105 },
+    { 0x00000a0aUL, 12, RF433ANY_ID_MANCHESTER, 108 },
+    { 0x00000a17UL, 12, RF433ANY_ID_TRIBIT, 137 },
+    { 0x00000afeUL, 12, RF433ANY_ID_TRIBIT, 139 },
+    { 0x00000c87UL, 12, RF433ANY_ID_TRIBIT, 110 },
+    { 0x00000c8aUL, 12, RF433ANY_ID_MANCHESTER, 131 },
+    { 0x00000cb8UL, 12, RF433ANY_ID_MANCHESTER, 132 },
+    { 0x00000cc8UL, 12, RF433ANY_ID_TRIBIT, 120 },
+    { 0x00039a7bUL, 24, RF433ANY_ID_TRIBIT_INV, 104 },
+    { 0x00045f21UL, 24, RF433ANY_ID_TRIBIT, 100 },
+    { 0x0005fb1aUL, 24, RF433ANY_ID_TRIBIT_INV, 138 },
+    { 0x0015f2cdUL, 24, RF433ANY_ID_MANCHESTER, 116 },
+    { 0x005408fcUL, 24, RF433ANY_ID_TRIBIT, 133 },
+    { 0x005bab1eUL, 24, RF433ANY_ID_MANCHESTER, 102 },
+    { 0x00730633UL, 24, RF433ANY_ID_TRIBIT, 136 },
+    { 0x008acac0UL, 24, RF433ANY_ID_TRIBIT_INV, 128 },
+    { 0x008c8ad6UL, 24, RF433ANY_ID_TRIBIT_INV, 129 },
+    { 0x00a472eaUL, 24, RF433ANY_ID_MANCHESTER, 119 },
+    { 0x00b7c936UL, 24, RF433ANY_ID_TRIBIT, 117 },
+    { 0x00ca9f21UL, 24, RF433ANY_ID_MANCHESTER, 118 },
+    { 0x15136429UL, 32, RF433ANY_ID_TRIBIT, 123 },
+    { 0x19b06963UL, 32, RF433ANY_ID_MANCHESTER, 135 },
+    { 0x1bea6f23UL, 32, RF433ANY_ID_TRIBIT_INV, 127 },
+    { 0x32135b34UL, 32, RF433ANY_ID_MANCHESTER, 122 },
+    { 0x5be72f6eUL, 32, RF433ANY_ID_TRIBIT_INV, 109 },
+    { 0x6bd6eed6UL, 32, RF433ANY_ID_TRIBIT_INV, 107 },
+    { 0x6c7ab5c9UL, 32, RF433ANY_ID_TRIBIT_INV, 101 },
+    { 0x7edc5678UL, 32, RF433ANY_ID_MANCHESTER, 6 },
+    { 0x7edc5679UL, 32, RF433ANY_ID_MANCHESTER, 7 },
+    { 0x9ef94bdaUL, 32, RF433ANY_ID_TRIBIT, 112 },
+    { 0xa918a1dcUL, 32, RF433ANY_ID_TRIBIT_INV, 115 },
+    { 0xd216fb71UL, 32, RF433ANY_ID_TRIBIT_INV, 126 },
+    { 0xeb32c0a6UL, 32, RF433ANY_ID_TRIBIT, 134 },
+    { 0xf0a9fed6UL, 32, RF433ANY_ID_TRIBIT_INV, 125 },
+    { 0xf7f3a683UL, 32, RF433ANY_ID_TRIBIT_INV, 114 },
+};
+
+#endif // _CODEBOOK_H
@@ -59,16 +59,49 @@ static void assert_failed(int line) {
         ;
 }
 
+#ifdef RF433ANY_DBG_SMALL_RECORDED
+    // BitVector words are bytes here, as on AVR: beyond 1024 bits, the
+    // storage can no longer double (255 words at most).
+#define LONG_BITVECTOR_NB_BITS 1100
+void check_long_bitvector() {
+    BitVector bv;
+    for (uint16_t i = 0; i < LONG_BITVECTOR_NB_BITS; ++i)
+        bv.add_bit((i % 3) == 0);
+    assert(bv.get_nb_bits() == LONG_BITVECTOR_NB_BITS);
+    assert(bv.get_nb_bytes() == (LONG_BITVECTOR_NB_BITS + 7) / 8);
+        // Bit 0 is the last one added
+    for (uint16_t i = 0; i < LONG_BITVECTOR_NB_BITS; ++i) {
+        assert(bv.get_nth_bit(LONG_BITVECTOR_NB_BITS - 1 - i)
+                == ((i % 3) == 0));
+    }
+}
+#endif
+
 void setup() {
     pinMode(PIN_RFINPUT, INPUT);
     Serial.begin(115200);
+#ifdef RF433ANY_DBG_SMALL_RECORDED
+    check_long_bitvector();
+#endif
 }
 
 Track track(PIN_RFINPUT);
 
+#if RF433ANY_TESTPLAN == 6
+    // Second receiver, fed with the second stream of timings (the one after
+    // the line "-" in input).
+TrackSlot<1> track1(PIN_RFINPUT + 1);
+duration_t sim_timings1[SIM_TIMINGS_LEN];
+uint16_t sim_timings1_count;
+#endif
+
 void read_simulated_timings_from_usb() {
     filter_mask_set = false;
     sim_timings_count = 0;
+#if RF433ANY_TESTPLAN == 6
+    sim_timings1_count = 0;
+    bool second_stream = false;
+#endif
     sim_int_count = 0;
     counter = 0;
     buffer[0] = '\0';
@@ -80,6 +113,13 @@ void read_simulated_timings_from_usb() {
         if (!strlen(buffer))
             continue;
 
+#if RF433ANY_TESTPLAN == 6
+        if (!strcmp(buffer, "-")) {
+            second_stream = true;
+            continue;
+        }
+#endif
+
         char *p = buffer;
         while (*p != ',' && *p != '\0')
             ++p;
@@ -106,6 +146,19 @@ void read_simulated_timings_from_usb() {
             sim_timings[sim_timings_count++] = compact(l);
             sim_timings[sim_timings_count++] = compact(h);
         }
+#elif RF433ANY_TESTPLAN == 6
+        if (second_stream) {
+            if (sim_timings1_count >=
+                    sizeof(sim_timings1) / sizeof(*sim_timings1) - 1) {
+                dbg("FATAL: timings buffer full!");
+                assert(false);
+            }
+            sim_timings1[sim_timings1_count++] = compact(l);
+            sim_timings1[sim_timings1_count++] = compact(h);
+        } else {
+            sim_timings[sim_timings_count++] = compact(l);
+            sim_timings[sim_timings_count++] = compact(h);
+        }
 #else
         sim_timings[sim_timings_count++] = compact(l);
         sim_timings[sim_timings_count++] = compact(h);
@@ -113,6 +166,72 @@ void read_simulated_timings_from_usb() {
     }
 }
 
+#if RF433ANY_TESTPLAN >= 11
+    // Replays the code of the input the way the loop of the other rounds
+    // does. Track is left in TRK_DATA, and do_events() has called the
+    // callbacks once.
+void feed_code() {
+    sim_int_count = 0;
+    track.treset();
+    while (track.get_trk() != TRK_DATA && sim_int_count <= sim_timings_count) {
+        for (int i = 0; i < 2; ++i) {
+            track.ih_handle_interrupt();
+        }
+        track.do_events();
+    }
+    track.force_stop_recv();
+    assert(track.get_trk() == TRK_DATA);
+}
+#endif
+
+#if RF433ANY_TESTPLAN >= 17
+    // Returns true if get_data() returns the same codes as in pref, with the
+    // same encodings.
+bool same_code(const Decoder *pref) {
+    Decoder *pdec0 = track.get_data(RF433ANY_FD_DECODED);
+    const Decoder *pdec = pdec0;
+    bool same = true;
+    for (   ; same && pref && pdec; pref = pref->get_next(),
+                                    pdec = pdec->get_next()) {
+        const BitVector *pdata = pdec->get_pdata();
+        const BitVector *pref_data = pref->get_pdata();
+        same = (pdec->get_id() == pref->get_id()
+                && (!pdata) == (!pref_data)
+                && (!pdata || !pdata->cmp(pref_data)));
+    }
+    same = same && !pref && !pdec;
+    delete pdec0;
+    return same;
+}
+#endif
+
+#if RF433ANY_TESTPLAN >= 18
+    // Pushes timings as the interrupt handler would, the main loop calling
+    // do_events() every two timings, as in feed_code(). The level alternates,
+    // starting with a low level after push_start().
+uint16_t nb_pushed;
+void push_start() {
+    nb_pushed = 0;
+    track.treset();
+}
+
+void push_timing(uint16_t d) {
+    track.ih_push_timing(nb_pushed & 1, d);
+    if (!(++nb_pushed & 1))
+        track.do_events();
+}
+
+    // Ends the code as feed_code() does once the input is over.
+void push_stop() {
+    for (byte i = 0; i < 2; ++i) {
+        track.ih_push_timing(nb_pushed & 1, 100);
+        track.do_events();
+    }
+    track.force_stop_recv();
+    assert(track.get_trk() == TRK_DATA);
+}
+#endif
+
 #if RF433ANY_TESTPLAN == 5
 void output_decoder(Decoder *pdec) {
     while (pdec) {
@@ -183,6 +302,1110 @@ void output_timings(Decoder *pdec, byte nb_bits) {
     dbg("-----CODE END-----\n");
 }
 
+#if RF433ANY_TESTPLAN == 6 || RF433ANY_TESTPLAN == 7
+void output_track(Track *ptrack, char name) {
+    Decoder *pdec = ptrack->get_data(RF433ANY_FD_ALL);
+    if (pdec) {
+        dbgf("Track %c", name);
+        pdec->dbg_decoder(2);
+        delete pdec;
+    }
+    ptrack->treset();
+}
+#endif
+
+#if RF433ANY_TESTPLAN == 6
+
+    // Feed one timing to the receiver, as if its interrupt handler had been
+    // called.
+    // Once the stream is over, feed two last timings of 100 us, as
+    // ih_handle_interrupt() does in simulation mode: it flushes the one-slot
+    // latency of the ring and terminates the last section.
+void feed_track(Track *ptrack, char name, const duration_t *timings,
+        uint16_t count, uint16_t *pi) {
+    if (*pi > count + 1)
+        return;
+    ptrack->ih_push_timing(*pi & 1,
+            *pi < count ? uncompact(timings[*pi]) : 100);
+    ++*pi;
+    ptrack->do_events();
+    if (ptrack->get_trk() == TRK_DATA)
+        output_track(ptrack, name);
+}
+
+    // The two receivers get their timings interleaved, one edge each in turn,
+    // as if both were receiving at the same time.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    track.treset();
+    track1.treset();
+    track.ih_reset_stats();
+    track1.ih_reset_stats();
+    uint16_t i0 = 0;
+    uint16_t i1 = 0;
+    while (i0 <= sim_timings_count + 1 || i1 <= sim_timings1_count + 1) {
+        feed_track(&track, 'A', sim_timings, sim_timings_count, &i0);
+        feed_track(&track1, 'B', sim_timings1, sim_timings1_count, &i1);
+    }
+    track.force_stop_recv();
+    track1.force_stop_recv();
+    output_track(&track, 'A');
+    output_track(&track1, 'B');
+
+    IH_stats_t stats0;
+    IH_stats_t stats1;
+    track.ih_get_stats(&stats0);
+    track1.ih_get_stats(&stats1);
+    dbgf("Dropped timings: A=%u, B=%u", stats0.nb_dropped, stats1.nb_dropped);
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 7
+
+#define IDLE_TIMEOUT_MS 100
+#define IDLE_STEP_US    500
+
+    // Virtual clock, in microseconds. It goes on from one test to the next,
+    // so that the first timing of a test (a low) follows a long silence.
+unsigned long vclock = 0;
+
+    // The timings are recorded as edges occurring at the time of the virtual
+    // clock. Once the stream is over, no more edges come: the code must be
+    // terminated by the idle timeout, at most one step of the clock after
+    // the timeout expired.
+    // Trailing timings of 0 are not edges (a stream that ends with a low
+    // ends with the line "<low>, 0").
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    uint16_t count = sim_timings_count;
+    while (count && !uncompact(sim_timings[count - 1]))
+        --count;
+
+    track.setopt_idle_timeout(IDLE_TIMEOUT_MS);
+    track.treset();
+    for (uint16_t i = 0; i < count; ++i) {
+        vclock += uncompact(sim_timings[i]);
+        track.ih_record_edge(i & 1, vclock);
+        track.do_events();
+        if (track.get_trk() == TRK_DATA)
+            output_track(&track, 'A');
+    }
+
+    unsigned long last_edge = vclock;
+    bool terminated = false;
+    while (!terminated && vclock - last_edge <= 2000000UL) {
+        vclock += IDLE_STEP_US;
+        track.do_events();
+        terminated = track.check_idle(vclock);
+    }
+    assert(terminated);
+    unsigned long latency = vclock - last_edge;
+    assert(latency <= IDLE_TIMEOUT_MS * 1000UL + IDLE_STEP_US);
+    dbgf("Terminated by idle timeout after %lu us", latency);
+    output_track(&track, 'A');
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 8
+
+#define STREAM_NB_REPEATS 500
+#define IDLE_TIMEOUT_MS   100
+#define IDLE_STEP_US      500
+
+#if defined(__AVR__)
+extern char *__brkval;
+extern char *__malloc_heap_start;
+    // The heap only grows when no freed block can be reused: if memory is
+    // not leaking, its end stays put.
+size_t heap_used() {
+    return __brkval ? __brkval - __malloc_heap_start : 0;
+}
+#elif defined(__GLIBC__)
+#include <malloc.h>
+size_t heap_used() { return mallinfo2().uordblks; }
+#else
+    // Not measured
+size_t heap_used() { return 0; }
+#endif
+
+unsigned long vclock = 0;
+
+struct stream_t {
+    uint16_t nb_frames;
+    uint16_t nb_identical;
+    char *first_data;
+    char first_id;
+    int first_nb_bits;
+    size_t heap_ref;
+    size_t heap_max;
+};
+
+    // Called for each frame. The first one is output, the next ones are
+    // compared with it. The heap is sampled from the second frame on (the
+    // first one allocates first_data).
+void on_frame(const Decoder *pdec, void *data) {
+    stream_t *ps = (stream_t *)data;
+    ++ps->nb_frames;
+
+    if (ps->nb_frames >= 2) {
+        size_t h = heap_used();
+        if (ps->nb_frames == 2)
+            ps->heap_ref = h;
+        if (h > ps->heap_max)
+            ps->heap_max = h;
+    }
+
+    const BitVector *pdata = pdec->get_pdata();
+    char *buf = (pdata ? pdata->to_str() : nullptr);
+    if (ps->nb_frames == 1) {
+        dbg("Frame 1");
+        pdec->dbg_decoder(2);
+        ps->first_data = buf;
+        ps->first_id = pdec->get_id_letter();
+        ps->first_nb_bits = pdec->get_nb_bits();
+        ++ps->nb_identical;
+        return;
+    }
+    if (pdec->get_id_letter() == ps->first_id
+            && pdec->get_nb_bits() == ps->first_nb_bits
+            && buf && ps->first_data && !strcmp(buf, ps->first_data)) {
+        ++ps->nb_identical;
+    }
+    if (buf)
+        free(buf);
+}
+
+    // The first line of the input is the initialization sequence, the next
+    // ones are one frame, separator included, that gets replayed
+    // STREAM_NB_REPEATS times: far beyond RF433ANY_MAX_SECTIONS. All frames
+    // must be delivered, and memory use must not grow with the number of
+    // frames. Once the stream is over, the last frame is delivered upon the
+    // idle timeout.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    stream_t st;
+    memset(&st, 0, sizeof(st));
+    track.setopt_idle_timeout(IDLE_TIMEOUT_MS);
+    track.setopt_stream(&on_frame, &st);
+    track.treset();
+
+    assert(sim_timings_count > 2);
+    for (uint16_t rep = 0; rep < STREAM_NB_REPEATS; ++rep) {
+        for (uint16_t i = (rep ? 2 : 0); i < sim_timings_count; ++i) {
+            vclock += uncompact(sim_timings[i]);
+            track.ih_record_edge(i & 1, vclock);
+            track.do_events();
+            assert(track.get_trk() != TRK_DATA);
+        }
+    }
+
+    unsigned long last_edge = vclock;
+    bool terminated = false;
+    while (!terminated && vclock - last_edge <= 2000000UL) {
+        vclock += IDLE_STEP_US;
+        track.do_events();
+        terminated = track.check_idle(vclock);
+    }
+    assert(terminated);
+    assert(track.get_trk() == TRK_WAIT);
+
+    dbgf("Frames: %u, identical to the first: %u", st.nb_frames,
+            st.nb_identical);
+    assert(st.heap_max == st.heap_ref);
+    dbg("Memory use: flat");
+
+    if (st.first_data)
+        free(st.first_data);
+    track.setopt_stream(nullptr, nullptr);
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 10
+
+#define W_BITS (sizeof(recorded_t) << 3)
+
+    // Pseudo-random generator (linear congruential), so that a given seed
+    // always produces the same sections, whatever the platform.
+unsigned long rnd_state;
+uint16_t rnd() {
+    rnd_state = rnd_state * 1103515245UL + 12345UL;
+    return (rnd_state >> 16) & 0x7FFF;
+}
+byte rnd_upto(byte n) { return rnd() % (n + 1); }
+recorded_t rnd_rec() {
+    recorded_t r = 0;
+    for (byte i = 0; i < W_BITS; i += 8)
+        r = (r << 8) | (rnd() & 0xFF);
+    return r;
+}
+recorded_t mask_of(byte n) {
+    return (n >= W_BITS ? ~(recorded_t)0 : ((recorded_t)1 << n) - 1);
+}
+
+    // Manchester signal of nb data bits (convention RF433ANY_CONV0), its
+    // leading low-then-high included: each run of one or two half-bits at
+    // the same level is a short or a long.
+void make_manchester(Section *psec, byte nb) {
+    recorded_t data = rnd_rec();
+    byte half[2 * W_BITS + 2];
+    byte n = 0;
+    half[n++] = 0;
+    half[n++] = 1;
+    for (byte i = 0; i < nb; ++i) {
+        byte v = (data >> i) & 1;
+        half[n++] = v;
+        half[n++] = !v;
+    }
+    byte nb_lo = 0;
+    byte nb_hi = 0;
+    for (byte i = 0; i < n; ) {
+        byte len = (i + 1 < n && half[i + 1] == half[i] ? 2 : 1);
+        if (half[i]) {
+            if (nb_hi < W_BITS && nb_hi < nb_lo) {
+                psec->high_rec = (psec->high_rec << 1) | (len - 1);
+                ++nb_hi;
+            }
+        } else if (nb_lo < W_BITS) {
+            psec->low_rec = (psec->low_rec << 1) | (len - 1);
+            ++nb_lo;
+        }
+        i += len;
+    }
+    psec->low_bits = nb_lo;
+    psec->high_bits = nb_hi;
+}
+
+    // A section either shaped for decoder id (sometimes with one signal
+    // flipped), or made of random signals.
+void make_section(Section *psec, byte id) {
+    memset(psec, 0, sizeof(*psec));
+    psec->low_bands = 2;
+    psec->high_bands = 2;
+    psec->ts.low_short = 500;
+    psec->ts.low_long = 1000;
+    psec->ts.high_short = 500;
+    psec->ts.high_long = 1000;
+    psec->ts.sep = 7000;
+    const uint16_t firsts[] = { 500, 1000, 3000 };
+    psec->first_low = firsts[rnd_upto(2)];
+    psec->first_high = firsts[rnd_upto(2)];
+    psec->last_low = 500;
+    psec->sts = (rnd_upto(3) ? STS_LONG_SEP : STS_CONTINUED);
+
+    byte shape = rnd_upto(3);
+    byte n = rnd_upto(W_BITS - 1);
+    if (shape == 0) {
+        psec->low_rec = rnd_rec() & mask_of(n + 1);
+        psec->high_rec = rnd_rec() & mask_of(n);
+        psec->low_bits = n + rnd_upto(1);
+        psec->high_bits = n;
+        if (rnd_upto(1) && psec->low_bits)
+            --psec->low_bits;
+        return;
+    }
+    if (id == RF433ANY_ID_MANCHESTER) {
+        make_manchester(psec, n);
+    } else {
+        byte n_low = n + rnd_upto(1);
+        recorded_t r = rnd_rec();
+        psec->high_rec = r & mask_of(n);
+        psec->low_rec = (id == RF433ANY_ID_TRIBIT ?
+                            ((~r & mask_of(n)) << (n_low - n))
+                          | (rnd_rec() & mask_of(n_low - n))
+                        : (~r >> 1) & mask_of(n_low));
+        psec->low_bits = n_low;
+        psec->high_bits = n;
+    }
+    if (shape == 1) {
+        recorded_t flip = (recorded_t)1 << rnd_upto(W_BITS - 1);
+        if (rnd_upto(1))
+            psec->low_rec ^= flip & mask_of(psec->low_bits);
+        else
+            psec->high_rec ^= flip & mask_of(psec->high_bits);
+    }
+}
+
+    // Decodes random sections, chained as in a code (a section having status
+    // STS_CONTINUED is continued by the next one), with the word-level
+    // decoding of DecoderTriBit, DecoderTriBitInv and DecoderManchester.
+    // RF433ANY_DBG_SIMULATE being defined, each section is also decoded one
+    // signal step at a time, and the library asserts both give the same
+    // result.
+    // Then the same goes through DecoderChain::add_section(), that chooses
+    // the decoder of each code, first trying the favorite one (see
+    // DecoderHits). The library asserts it is the one DecoderProbe chooses.
+    // Each line of input is "seed, number of codes", both being multiples of
+    // 16 lower than 2048 (they go through compact() and uncompact()).
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    for (uint16_t t = 0; t < sim_timings_count; t += 2) {
+        rnd_state = uncompact(sim_timings[t]);
+        uint16_t nb_codes = uncompact(sim_timings[t + 1]);
+        dbgf("Seed %lu, %u codes", rnd_state, nb_codes);
+
+        for (byte id = RF433ANY_ID_TRIBIT; id <= RF433ANY_ID_MANCHESTER;
+                ++id) {
+            for (byte conv = RF433ANY_CONV0; conv <= RF433ANY_CONV1; ++conv) {
+                unsigned long nb_sections = 0;
+                unsigned long nb_bits = 0;
+                unsigned long nb_errors = 0;
+                uint16_t sum = 0;
+                for (uint16_t c = 0; c < nb_codes; ++c) {
+                    Decoder *pdec = Decoder::build_decoder(id, conv);
+                    Section sec;
+                    byte k = 0;
+                    do {
+                        make_section(&sec, id);
+                        pdec->decode_section(&sec, k);
+                        ++nb_sections;
+                    } while (sec.sts == STS_CONTINUED && ++k < 3);
+                    nb_bits += pdec->get_nb_bits();
+                    nb_errors += pdec->get_nb_errors();
+                    const BitVector *pdata = pdec->get_pdata();
+                    if (pdata) {
+                        for (uint16_t i = 0; i < pdata->get_nb_bytes(); ++i)
+                            sum = sum * 31 + pdata->get_nth_byte(i);
+                    }
+                    delete pdec;
+                }
+                dbgf("  %c conv %u: sections: %5lu, bits: %6lu, "
+                     "errors: %5lu, sum: %04X",
+                     "TNM"[id - RF433ANY_ID_TRIBIT], conv, nb_sections,
+                     nb_bits, nb_errors, sum);
+            }
+        }
+
+            // Mostly Manchester, so that the favorite changes along the way
+        DecoderHits hits;
+        hits.reset();
+        DecoderChain chain;
+        chain.init(&hits);
+        for (uint16_t c = 0; c < nb_codes; ++c) {
+            byte r = rnd_upto(9);
+            byte id = (r < 6 ? RF433ANY_ID_MANCHESTER :
+                       r < 8 ? RF433ANY_ID_TRIBIT : RF433ANY_ID_TRIBIT_INV);
+            Section sec;
+            byte k = 0;
+            do {
+                make_section(&sec, id);
+                chain.add_section(&sec, 0, RF433ANY_CONV0);
+            } while (sec.sts == STS_CONTINUED && ++k < 3);
+            Decoder *pdec = chain.close();
+            delete pdec;
+        }
+        dbgf("  Chain hits: S: %u, T: %u, N: %u, M: %u, U: %u",
+                hits.hits[RF433ANY_ID_RAW_SYNC], hits.hits[RF433ANY_ID_TRIBIT],
+                hits.hits[RF433ANY_ID_TRIBIT_INV],
+                hits.hits[RF433ANY_ID_MANCHESTER],
+                hits.hits[RF433ANY_ID_RAW_UNKNOWN_CODING]);
+    }
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 11
+
+#define SOAK_NB_FRAMES 1000
+
+#if defined(__GLIBC__)
+    // Each call to the heap is counted.
+extern "C" {
+void *__libc_malloc(size_t n);
+void *__libc_calloc(size_t nmemb, size_t n);
+void *__libc_realloc(void *p, size_t n);
+void __libc_free(void *p);
+
+unsigned long nb_heap_calls = 0;
+void *malloc(size_t n) { ++nb_heap_calls; return __libc_malloc(n); }
+void *calloc(size_t nmemb, size_t n) {
+    ++nb_heap_calls;
+    return __libc_calloc(nmemb, n);
+}
+void *realloc(void *p, size_t n) {
+    ++nb_heap_calls;
+    return __libc_realloc(p, n);
+}
+void free(void *p) {
+    if (p)
+        ++nb_heap_calls;
+    __libc_free(p);
+}
+}
+unsigned long heap_state() { return nb_heap_calls; }
+#elif defined(__AVR__)
+    // The heap is untouched if its end and its list of free blocks stay put.
+extern char *__brkval;
+extern "C" void *__flp;
+unsigned long heap_state() {
+    return (unsigned long)(uint16_t)__brkval
+           | ((unsigned long)(uint16_t)__flp << 16);
+}
+#else
+    // Not measured
+unsigned long heap_state() { return 0; }
+#endif
+
+uint16_t nb_called;
+void on_code(void *data) {
+    ++*(uint16_t *)data;
+}
+
+    // The code of the input gets decoded and registered as a callback, then
+    // it is replayed SOAK_NB_FRAMES times through the callbacks. Decoders,
+    // their data and the callback record are in the arena: the heap must be
+    // left untouched, and the arena must be released after each frame,
+    // its highest use staying the same.
+    // The code of each test must be different from the ones before, as
+    // callbacks stay registered from one test to the next.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    feed_code();
+    Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+    assert(pdec);
+    pdec->dbg_decoder(2);
+
+        // The code of the callback belongs to the caller: it is on the heap
+    const BitVector *pdata = pdec->get_pdata();
+    BitVector *pcode = new BitVector();
+    for (short i = pdata->get_nb_bits() - 1; i >= 0; --i)
+        pcode->add_bit(pdata->get_nth_bit(i));
+    nb_called = 0;
+    track.register_callback(pdec->get_id(), pcode, &nb_called, on_code, 0);
+    delete pdec;
+    assert(!RF433any_arena.get_used());
+
+    unsigned long heap_ref = heap_state();
+    RF433any_arena.reset_stats();
+    arena_stats_t stats_ref;
+    arena_stats_t stats;
+    for (uint16_t n = 0; n < SOAK_NB_FRAMES; ++n) {
+        feed_code();
+        assert(!RF433any_arena.get_used());
+        if (!n)
+            RF433any_arena.get_stats(&stats_ref);
+    }
+    unsigned long heap = heap_state();
+    RF433any_arena.get_stats(&stats);
+
+    dbgf("Frames: %u, callback called: %u", SOAK_NB_FRAMES, nb_called);
+    assert(heap == heap_ref);
+    dbg("Heap: untouched");
+    assert(stats.max_used == stats_ref.max_used && !stats.nb_overflows);
+    dbg("Arena: flat, no overflow");
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 12
+
+#define CB_NB_DECOYS 4
+#define CB_MAX_CALLED 8
+
+    // Pseudo-random generator (linear congruential), so that the decoys are
+    // the same whatever the platform.
+unsigned long rnd_state = 12;
+uint16_t rnd() {
+    rnd_state = rnd_state * 1103515245UL + 12345UL;
+    return (rnd_state >> 16) & 0x7FFF;
+}
+
+byte nb_called;
+byte called[CB_MAX_CALLED];
+void on_code(void *data) {
+    if (nb_called < CB_MAX_CALLED)
+        called[nb_called++] = (byte)(uintptr_t)data;
+}
+
+    // The first n bits of pdata (the ones received first), plus one random
+    // bit if n is the number of bits of pdata plus one. The bit received
+    // flip-th (counting from 0) is inverted.
+BitVector *copy_code(const BitVector *pdata, short n, short flip = -1) {
+    BitVector *pcode = new BitVector();
+    for (short i = 0; i < n; ++i) {
+        short k = pdata->get_nb_bits() - 1 - i;
+        byte v = (k >= 0 ? pdata->get_nth_bit(k) : rnd() & 1);
+        pcode->add_bit(i == flip ? !v : v);
+    }
+    return pcode;
+}
+
+    // n bits, the ones received from first-th to last-th being set
+BitVector *make_mask(short n, short first, short last) {
+    BitVector *pmask = new BitVector();
+    for (short i = 0; i < n; ++i)
+        pmask->add_bit(i >= first && i <= last);
+    return pmask;
+}
+
+    // The code of the input gets decoded and registered as a callback, among
+    // decoys (codes that differ by their bits, their length or their
+    // encoding), then with masks: on its first half of bits (with a bit
+    // inverted in the mask or out of it), on its last bit, and on one bit more
+    // than it has. Then the code is replayed once through the callbacks. The
+    // callbacks called are printed in the order of the calls: callbacks
+    // without mask in the order of registration, then the ones with a mask,
+    // mask by mask.
+    // The callback number is printed. The code of each test must be different
+    // from the ones before, and of a different length, as callbacks stay
+    // registered from one test to the next.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    feed_code();
+    Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+    assert(pdec);
+    pdec->dbg_decoder(2);
+    const BitVector *pdata = pdec->get_pdata();
+    short n = pdata->get_nb_bits();
+    byte id = pdec->get_id();
+    byte other_id = (id == RF433ANY_ID_MANCHESTER ?
+            RF433ANY_ID_TRIBIT : RF433ANY_ID_MANCHESTER);
+
+    byte k = 0;
+    track.register_callback(id, copy_code(pdata, n), (void*)(uintptr_t)k++,
+            on_code, 0);
+    for (byte i = 0; i < CB_NB_DECOYS; ++i) {
+        BitVector *pcode = new BitVector();
+        for (short j = 0; j < n; ++j)
+            pcode->add_bit(rnd() & 1);
+        if (!pcode->cmp(pdata)) {
+            delete pcode;
+            pcode = copy_code(pdata, n - 1);
+            pcode->add_bit(!pdata->get_nth_bit(0));
+        }
+        track.register_callback(id, pcode, (void*)(uintptr_t)k++, on_code, 0);
+    }
+    track.register_callback(id, copy_code(pdata, n - 1),
+            (void*)(uintptr_t)k++, on_code, 0);
+    track.register_callback(id, copy_code(pdata, n + 1),
+            (void*)(uintptr_t)k++, on_code, 0);
+    track.register_callback(other_id, copy_code(pdata, n),
+            (void*)(uintptr_t)k++, on_code, 0);
+    track.register_callback(RF433ANY_ID_ANY_ENCODING, copy_code(pdata, n),
+            (void*)(uintptr_t)k++, on_code, 0);
+    track.register_callback(id, copy_code(pdata, n), (void*)(uintptr_t)k++,
+            on_code, 0);
+
+    const BitVector *pmask = make_mask(n, 0, n / 2 - 1);
+    track.register_callback(id, copy_code(pdata, n), pmask,
+            (void*)(uintptr_t)k++, on_code, 0);
+    track.register_callback(id, copy_code(pdata, n, 0), pmask,
+            (void*)(uintptr_t)k++, on_code, 0);
+    track.register_callback(id, copy_code(pdata, n, n - 1),
+            make_mask(n, 0, n / 2 - 1), (void*)(uintptr_t)k++, on_code, 0);
+    track.register_callback(RF433ANY_ID_ANY_ENCODING, copy_code(pdata, n),
+            make_mask(n, n - 1, n - 1), (void*)(uintptr_t)k++, on_code, 0);
+    track.register_callback(id, copy_code(pdata, n + 1),
+            make_mask(n + 1, 0, n / 2 - 1), (void*)(uintptr_t)k++, on_code, 0);
+    delete pdec;
+
+    nb_called = 0;
+    feed_code();
+
+    dbgf("Registered: %u, called: %u", k, nb_called);
+    for (byte i = 0; i < nb_called; ++i)
+        dbgf("  Callback %u", called[i]);
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 13
+
+#include "codebook.h"
+
+void on_action(uint16_t action, void *data) {
+    (void)data;
+    dbgf("  Action %u", action);
+}
+
+    // Same as codebook_find(), by a linear search
+uint16_t find_linear(byte nb_bits, uint32_t code) {
+    codebook_entry_t entry;
+    for (uint16_t i = 0; i < CODEBOOK_NB_ENTRIES; ++i) {
+        codebook_get_entry(codebook, i, &entry);
+        if (entry.nb_bits == nb_bits && entry.code == code)
+            return i;
+    }
+    return CODEBOOK_NB_ENTRIES;
+}
+
+    // Looks up the code of each entry of the code book (codebook.h, generated
+    // from codebook.txt), and the code that follows it. Returns the number of
+    // lookups that went wrong.
+uint16_t check_lookups() {
+    uint16_t nb_errors = 0;
+    codebook_entry_t entry;
+    for (uint16_t i = 0; i < CODEBOOK_NB_ENTRIES; ++i) {
+        codebook_get_entry(codebook, i, &entry);
+        for (byte d = 0; d < 2; ++d) {
+            if (codebook_find(codebook, CODEBOOK_NB_ENTRIES, entry.nb_bits,
+                        entry.code + d)
+                    != find_linear(entry.nb_bits, entry.code + d))
+                ++nb_errors;
+        }
+    }
+    return nb_errors;
+}
+
+    // The code of the input goes through the code book, then gets decoded:
+    // the actions of the entries having the code, with an encoding that
+    // matches, are printed in the order of the code book.
+void loop() {
+    static bool codebook_registered = false;
+    if (!codebook_registered) {
+        track.register_codebook(codebook, CODEBOOK_NB_ENTRIES, on_action,
+                nullptr);
+        codebook_registered = true;
+    }
+
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    feed_code();
+    Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+    assert(pdec);
+    pdec->dbg_decoder(2);
+    delete pdec;
+
+    dbgf("Lookups: %u entries, %u error(s)", CODEBOOK_NB_ENTRIES,
+            check_lookups());
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 14
+
+#define RECENT_WINDOW 200
+
+uint16_t nb_called;
+void on_code(void *data) {
+    (void)data;
+    ++nb_called;
+}
+
+    // Replays the code nb_frames times, every_ms apart, each frame going
+    // through the callbacks after a reset of Track (like a remote sending its
+    // code several times, with silences in between), after a silence longer
+    // than the window.
+void burst(uint16_t window, byte nb_frames, uint16_t every_ms) {
+    track.setopt_recent_window(window);
+    delay(RECENT_WINDOW + 100);
+    nb_called = 0;
+    for (byte n = 0; n < nb_frames; ++n) {
+        if (n)
+            delay(every_ms);
+        feed_code();
+    }
+    dbgf("Window %3u ms, %2u frames every %3u ms: %2u call(s)", window,
+            nb_frames, every_ms, nb_called);
+}
+
+    // The code of the input gets decoded and registered as a callback, then
+    // replayed in bursts. Codes within the window are dropped before the
+    // callbacks, the window counting from the last time the code was seen.
+    // The code of each test must be different from the ones before, as
+    // callbacks stay registered from one test to the next.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    feed_code();
+    Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+    assert(pdec);
+    pdec->dbg_decoder(2);
+    const BitVector *pdata = pdec->get_pdata();
+    BitVector *pcode = new BitVector();
+    for (short i = pdata->get_nb_bits() - 1; i >= 0; --i)
+        pcode->add_bit(pdata->get_nth_bit(i));
+    track.register_callback(pdec->get_id(), pcode, nullptr, on_code, 0);
+    delete pdec;
+
+        // Window off: each frame triggers a call
+    burst(0, 5, 50);
+        // One call per burst
+    burst(RECENT_WINDOW, 5, 50);
+    burst(RECENT_WINDOW, 3, 50);
+        // Button held down: frames keep coming within the window
+    burst(RECENT_WINDOW, 10, RECENT_WINDOW * 3 / 4);
+        // Frames further apart than the window
+    burst(RECENT_WINDOW, 3, RECENT_WINDOW * 2);
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 15
+
+void output_codes(const char *name, uint16_t filter) {
+    dbgf("%s", name);
+    feed_code();
+    Decoder *pdec0 = track.get_data(filter);
+    for (Decoder *pdec = pdec0; pdec; pdec = pdec->get_next()) {
+        char *buf = pdec->get_pdata()->to_str();
+        dbgf("  %c %s, copies: %u, confidence: %u%%", pdec->get_id_letter(),
+                buf, pdec->get_repeats() + 1, pdec->get_confidence());
+        free(buf);
+    }
+    delete pdec0;
+}
+
+    // The code of the input (some copies of which got bits inverted) is
+    // printed without and with majority vote, with the number of copies of
+    // each code and the confidence.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    output_codes("Dedup:", RF433ANY_FD_DECODED | RF433ANY_FD_DEDUP);
+    output_codes("Vote:", RF433ANY_FD_DECODED | RF433ANY_FD_VOTE);
+    output_codes("Dedup and vote:",
+            RF433ANY_FD_DECODED | RF433ANY_FD_DEDUP | RF433ANY_FD_VOTE);
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 16
+
+#define RECENT_WINDOW 200
+
+byte nb_recent_codes() {
+    Decoder *pdec0 = track.get_data(RF433ANY_FD_DECODED | RF433ANY_FD_DEDUP
+                                    | RF433ANY_FD_NOT_RECENT);
+    byte n = 0;
+    for (Decoder *pdec = pdec0; pdec; pdec = pdec->get_next())
+        ++n;
+    delete pdec0;
+    return n;
+}
+
+uint16_t nb_called;
+bool get_data_in_callback;
+uint16_t nb_codes_in_callback;
+void on_code(void *data) {
+    (void)data;
+    ++nb_called;
+    if (get_data_in_callback)
+        nb_codes_in_callback += nb_recent_codes();
+}
+
+    // Replays the code nb_frames times, every_ms apart, after a silence longer
+    // than the window. Each frame goes through do_events() (that calls the
+    // callbacks), then through get_data() with RF433ANY_FD_NOT_RECENT, twice.
+    // If in_callback is true, the first call to get_data() is made by the
+    // callback instead.
+void burst(byte nb_frames, uint16_t every_ms, bool in_callback) {
+    delay(RECENT_WINDOW + 100);
+    nb_called = 0;
+    get_data_in_callback = in_callback;
+    nb_codes_in_callback = 0;
+    uint16_t nb_codes[2] = { 0, 0 };
+    for (byte n = 0; n < nb_frames; ++n) {
+        if (n)
+            delay(every_ms);
+        feed_code();
+        if (!in_callback)
+            nb_codes[0] += nb_recent_codes();
+        nb_codes[1] += nb_recent_codes();
+    }
+    if (in_callback)
+        nb_codes[0] = nb_codes_in_callback;
+    dbgf("%2u frames every %3u ms, %s: %2u call(s), get_data(): %2u and %2u "
+            "code(s)", nb_frames, every_ms,
+            in_callback ? "get_data() in callback" : "do_events() first",
+            nb_called, nb_codes[0], nb_codes[1]);
+}
+
+    // The code of the input gets decoded and registered as a callback, then
+    // replayed in bursts. The codes get_data() removes as recent must be the
+    // same as for the callbacks, whatever the order of the calls.
+    // The code of each test must be different from the ones before, as
+    // callbacks stay registered from one test to the next.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    track.setopt_recent_window(RECENT_WINDOW);
+
+    feed_code();
+    Decoder *pdec = track.get_data(RF433ANY_FD_DECODED);
+    assert(pdec);
+    pdec->dbg_decoder(2);
+    const BitVector *pdata = pdec->get_pdata();
+    BitVector *pcode = new BitVector();
+    for (short i = pdata->get_nb_bits() - 1; i >= 0; --i)
+        pcode->add_bit(pdata->get_nth_bit(i));
+    track.register_callback(pdec->get_id(), pcode, nullptr, on_code, 0);
+    delete pdec;
+
+    burst(1, 0, false);
+    burst(5, 50, false);
+    burst(5, 50, true);
+        // Button held down: frames keep coming within the window
+    burst(10, RECENT_WINDOW * 3 / 4, false);
+        // Frames further apart than the window
+    burst(3, RECENT_WINDOW * 2, false);
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 17
+
+#define STORM_MAX_RATE   10000 // Edges per second
+#define STORM_BACKOFF_MS   500
+#define STORM_NB_EDGES     400
+
+    // Interference of a nearby device: timings of 5 to 84 us, that is, 12000
+    // to 200000 edges per second.
+uint16_t storm_timing(uint16_t i) {
+    return 5 + (i * 37) % 80;
+}
+
+    // The code of the input gets decoded, then a storm of edges comes, the
+    // main loop calling do_events() every two edges. The storm guard must
+    // detect it once, discard the edges that follow, and not record again
+    // before the backoff delay. Then the code is replayed, and must be
+    // decoded the same as before the storm.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    track.setopt_ih_storm_guard(STORM_MAX_RATE, STORM_BACKOFF_MS);
+    track.ih_reset_stats();
+
+    feed_code();
+    Decoder *pref = track.get_data(RF433ANY_FD_DECODED);
+    assert(pref);
+    pref->dbg_decoder(2);
+    track.treset();
+
+    IH_storm_stats_t stats;
+    uint16_t nb_edges_to_detect = 0;
+    for (uint16_t i = 0; i < STORM_NB_EDGES; ++i) {
+        track.ih_get_storm_stats(&stats);
+        if (!stats.in_storm)
+            ++nb_edges_to_detect;
+        track.ih_push_timing(i & 1, storm_timing(i));
+        if (i & 1)
+            track.do_events();
+    }
+    track.ih_get_storm_stats(&stats);
+    assert(stats.in_storm && stats.nb_episodes == 1);
+    dbgf("Storm detected after %u edges, %u edges discarded",
+            nb_edges_to_detect, STORM_NB_EDGES - nb_edges_to_detect);
+
+    delay(STORM_BACKOFF_MS / 2);
+    track.do_events();
+    track.ih_get_storm_stats(&stats);
+    assert(stats.in_storm);
+    dbg("Half the backoff delay: still in storm");
+
+    delay(STORM_BACKOFF_MS / 2 + 1);
+    track.do_events();
+    track.ih_get_storm_stats(&stats);
+    assert(!stats.in_storm && stats.nb_episodes == 1
+            && stats.total_ms >= STORM_BACKOFF_MS);
+    dbgf("Backoff delay elapsed: recording, %u episode(s)", stats.nb_episodes);
+
+    feed_code();
+    assert(same_code(pref));
+    dbg("Code after the storm: same");
+    delete pref;
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 18
+
+#define SQUELCH_NB_NOISE    24
+#define SQUELCH_GLITCH_D    20
+#define SQUELCH_GLITCH_EVERY 3
+
+    // Noise that is not a glitch, and not an initialization sequence either:
+    // timings of 200 to 1100 us.
+uint16_t noise_timing(uint16_t i) {
+    return 200 + (i * 150) % 1000;
+}
+
+    // The code of the input gets decoded without the squelch. Then, with the
+    // squelch, the code is replayed after some noise, a glitch being inserted
+    // in one timing out of SQUELCH_GLITCH_EVERY. The noise must be discarded
+    // (the gate is closed), and each glitch merged into the timing it falls
+    // in, so that the code is decoded the same as without the squelch.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    track.setopt_ih_squelch(0);
+    feed_code();
+    Decoder *pref = track.get_data(RF433ANY_FD_DECODED);
+    assert(pref);
+    pref->dbg_decoder(2);
+
+    track.setopt_ih_squelch(RF433ANY_IH_SQUELCH_MIN_D);
+    track.ih_reset_stats();
+    push_start();
+    for (uint16_t i = 0; i < SQUELCH_NB_NOISE; ++i)
+        push_timing(noise_timing(i));
+    uint16_t nb_glitches = 0;
+    for (uint16_t i = 0; i < sim_timings_count; ++i) {
+        uint16_t d = uncompact(sim_timings[i]);
+        if (i % SQUELCH_GLITCH_EVERY == SQUELCH_GLITCH_EVERY - 1) {
+                // The pulse d becomes a, glitch, c, with a + glitch + c = d
+            uint16_t a = d / 2;
+            push_timing(a);
+            push_timing(SQUELCH_GLITCH_D);
+            push_timing(d - a - SQUELCH_GLITCH_D);
+            ++nb_glitches;
+        } else {
+            push_timing(d);
+        }
+    }
+    push_stop();
+
+    IH_squelch_stats_t stats;
+    track.ih_get_squelch_stats(&stats);
+    dbgf("Noise: %u timings, glitches: %u", SQUELCH_NB_NOISE, nb_glitches);
+    dbgf("Squelch: %lu forwarded, %lu dropped",
+            (unsigned long)stats.nb_forwarded, (unsigned long)stats.nb_dropped);
+    assert(same_code(pref));
+    dbg("Code with the squelch: same");
+    delete pref;
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 19
+
+#define QUEUE_NB_COPIES (RF433ANY_RAWCODE_QUEUE + 1)
+#define QUEUE_NB_NOISE  8 // Timings of noise between two copies (even number)
+#define QUEUE_NOISE_D  30
+
+    // The code of the input gets decoded, then replayed QUEUE_NB_COPIES times,
+    // each copy being preceded by a short burst of noise (as output by
+    // receivers when no code is being transmitted), that ends the reception
+    // of the copy before. The main loop keeps calling do_events() but does
+    // not process the codes: the first ones must be queued while reception
+    // goes on, and the last one must wait in Track. Then each copy is read
+    // with get_data() and discarded with treset(), in the order received.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    feed_code();
+    Decoder *pref = track.get_data(RF433ANY_FD_DECODED);
+    assert(pref);
+    pref->dbg_decoder(2);
+    track.treset();
+
+    push_start();
+    for (byte c = 0; c < QUEUE_NB_COPIES; ++c) {
+        for (byte i = 0; i < QUEUE_NB_NOISE; ++i)
+            push_timing(QUEUE_NOISE_D);
+            // The first timing of the input is the low level before the
+            // initialization sequence, it is replaced by noise.
+        push_timing(QUEUE_NOISE_D);
+        for (uint16_t i = 1; i < sim_timings_count; ++i)
+            push_timing(uncompact(sim_timings[i]));
+    }
+    push_stop();
+
+    byte nb_received = 0;
+    byte nb_same = 0;
+    while (track.get_trk() == TRK_DATA && nb_received < QUEUE_NB_COPIES) {
+        ++nb_received;
+        if (same_code(pref))
+            ++nb_same;
+        track.treset();
+    }
+    dbgf("Copies sent: %u, received: %u, same as the code: %u",
+            QUEUE_NB_COPIES, nb_received, nb_same);
+    assert(nb_received == QUEUE_NB_COPIES && nb_same == nb_received);
+    assert(track.get_trk() != TRK_DATA);
+    delete pref;
+
+    dbg("----- END TEST -----");
+}
+
+#elif RF433ANY_TESTPLAN == 20
+
+const byte drift_levels[] = { 20, 40, 60, 80 };
+
+    // The code of the input gets decoded, then replayed with a drift: the
+    // timings get longer and longer, up to level% longer at the end of the
+    // input (like a remote the clock of which drifts as it warms up, or as
+    // its battery runs out). The bands of the rails must follow, so that
+    // the code is decoded the same.
+    // Without RF433ANY_ADAPTIVE_BANDS, code-flo1 is decoded differently from
+    // +40% on.
+void loop() {
+    read_simulated_timings_from_usb();
+
+    delay(100);
+    dbg("----- BEGIN TEST -----");
+
+    feed_code();
+    Decoder *pref = track.get_data(RF433ANY_FD_DECODED);
+    assert(pref);
+    pref->dbg_decoder(2);
+
+    for (byte l = 0; l < sizeof(drift_levels); ++l) {
+        byte level = drift_levels[l];
+        push_start();
+        for (uint16_t i = 0; i < sim_timings_count; ++i) {
+            uint32_t d = uncompact(sim_timings[i]);
+            d += d * level * i / (100UL * sim_timings_count);
+            push_timing(d);
+        }
+        push_stop();
+        assert(same_code(pref));
+        dbgf("Drift up to +%u%%: same", level);
+    }
+    delete pref;
+
+    dbg("----- END TEST -----");
+}
+
+#else
+
 void loop() {
     if (sim_int_count >= sim_timings_count)
         read_simulated_timings_from_usb();
@@ -201,7 +1424,7 @@ void loop() {
     sim_int_count_svg = sim_int_count;
     while (track.get_trk() != TRK_DATA && sim_int_count <= sim_timings_count) {
         for (int i = 0; i < 2; ++i) {
-            Track::ih_handle_interrupt();
+            track.ih_handle_interrupt();
         }
         track.do_events();
     }
@@ -237,4 +1460,6 @@ void loop() {
     }
 }
 
+#endif
+
 // vim: ts=4:sw=4:tw=80:et
@@ -34,7 +34,7 @@ FAILED=0
 cd ..
 
 START=1
-STOP=5
+STOP=20
 if [ -n "${1:-}" ]; then
     START="$1";
     STOP="$1";
@@ -54,6 +54,22 @@ for ((i=START; i<=STOP; i++)); do
         cd testplan/decoder
     elif [ "${i}" -le 5 ]; then
         cd testplan/user
+    elif [ "${i}" -le 6 ]; then
+        cd testplan/multi
+    elif [ "${i}" -le 7 ]; then
+        cd testplan/idle
+    elif [ "${i}" -le 8 ]; then
+        cd testplan/stream
+    elif [ "${i}" -le 9 ]; then
+        cd testplan/multiwidth
+    elif [ "${i}" -le 10 ]; then
+        cd testplan/worddec
+    elif [ "${i}" -le 14 ]; then
+        cd testplan/replay
+    elif [ "${i}" -le 15 ]; then
+        cd testplan/vote
+    elif [ "${i}" -le 20 ]; then
+        cd testplan/replay
     else
 
         echo "Unknown testplan number, aborted."